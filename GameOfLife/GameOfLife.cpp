@@ -7,9 +7,77 @@
 * Keyboard controls:
 * - Space: play / pause simulation
 * - T: single-step the simulation
+* - Left / right mouse drag: paint / erase cells under the cursor
+* - [ / ]: halve / double the generations simulated per frame
+* - H: toggle the cell-age heatmap view
+* - Left / Right: step back / forward through the history ring (--history)
+* - F: toggle the diff view, highlighting births and deaths against the
+*   generation before the one on screen (--history)
+* - R: simulate only the viewport (approximately - the frozen rest of the
+*   board bleeds in over time), for poking at one corner of a huge grid on
+*   the cheap
+* - I: toggle the GPU timing readout in the window title
 * - W/A/S/D: pan the viewport
 * - - / =: zoom the viewport
-* 
+*
+* Command line options:
+* - --benchmark <generations>: run headless (no visible window, no rendering)
+*   for the given number of generations, then print throughput numbers
+* - --width / --height <cells>: the dimensions of the board to simulate
+*   (defaults to 400 x 400; the inital setup image must match)
+* - --csv <file>: stream per-frame GPU timings (compute & render, in
+*   milliseconds) to a CSV file
+* - --checkpoint <generations>: periodically save the board to
+*   checkpoint.board (plus a checkpoint.state sidecar holding the
+*   generation counter, tick batch size and viewport), read back and
+*   written without stalling the simulation
+* - --resume: pick up from the last checkpoint - the board comes back in
+*   one memory-mapped read, and the sidecar restores the generation
+*   counter, scheduler and viewport, so a crashed multi-day run carries on
+*   in seconds instead of recomputing
+* - --sparse: only dispatch the simulation over tiles of the board that
+*   changed recently - a big win on mostly-dead boards
+* - --cpu: simulate on the CPU instead of the GPU (this also happens
+*   automatically when the driver can't provide OpenGL 4.3)
+* - --place <pattern.rle> <x> <y>: stamp an RLE pattern onto the board at
+*   the given position (repeatable; x/y from the top-left corner)
+* - --boundary <dead|wrap|reflect>: what lies past the edges of the board -
+*   dead cells (the default), a toroidal wrap to the opposite edge, or a
+*   mirror. The wrapping modes need the board width to be a multiple of 32
+* - --partitions <n>: split the board into n horizontal bands, each
+*   simulated on its own GL context and thread, exchanging one-row halo
+*   strips every generation - for boards too big for one queue to chew
+*   through
+* - --fastforward <generations>: jump the board to the given generation
+*   with the HashLife engine before anything else starts, then carry on
+*   normally from there - for reproducing "state at generation 10^9" bugs
+* - --census <file>: stream every generation's live-cell count to a CSV
+*   file, counted by a reduction pass on the GPU and read back behind a
+*   fence so the pipeline never stalls for it
+* - --record <file> <generations>: capture the board every so many
+*   generations into a single stream file of packed bitplane frames, read
+*   back asynchronously so recording doesn't slow the simulation down
+* - --seed <n>: skip the setup image and generate a random starting board
+*   on the GPU instead, deterministically from the seed - the same seed,
+*   size and density always give the same board
+* - --density <0..1>: the fraction of cells alive in a generated board
+*   (defaults to 0.5; only meaningful together with --seed)
+* - --history <k>: keep the last k generations in a bit-packed texture
+*   array on the GPU, for instant rewind (Left/Right) and the diff view
+*   (F) with no readback on the hot path
+* - --detect <k>: watch for the board settling into a still life or an
+*   oscillation of period up to k, entirely on the GPU. Interactive runs
+*   pause when it happens; a benchmark stops early and exits with status 2,
+*   so batch sweeps can cull boards that have finished changing
+* - --gps <n>: pace the simulation at n generations per wall-clock second
+*   instead of a fixed batch per frame, so the same board runs at the same
+*   speed on a 144 Hz workstation and a 60 Hz wall display
+* - --uncapped: disable vsync, for maximum frame (and simulation) rate
+* - --rule <B.../S...>: the Life-like rule to play, in B/S notation - e.g.
+*   B36/S23 for HighLife or B3678/S34678 for Day & Night (defaults to plain
+*   B3/S23). The rule is compiled into the kernel, so variant rules run
+*   exactly as fast as standard Life
+*
 * by ConorB
 */
 
@@ -19,22 +87,91 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "cpuengine.h"
+#include "hashlife.h"
+#include "shaderprograms.h"
+#include "gpuengine.h"
+
 #include <string>
 #include <sstream>
 #include <fstream>
 #include <iostream>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+// Platform bits for memory-mapping board files
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <direct.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 // Constants
 // The image file we load our inital board state from. This must have dimensions gridWidth x gridHeight
 const char* INITAL_SETUP_PATH = "inital_setup.png";
 
+// If this file exists, we memory-map it and upload it directly instead of
+// decoding the PNG - on big boards that's the difference between a cold start
+// of tens of seconds and a few milliseconds.
+//
+// A .board file is a little-endian sequence of 32-bit words: a 'GOLB' magic
+// word, the width in cells, the height in cells, then height rows of
+// ceil(width / 32) packed words, bit i of each word holding cell
+// (wordX * 32 + i, y). Rows run bottom-to-top, matching the flipped PNG load
+const char* BOARD_SETUP_PATH = "inital_setup.board";
+const uint32_t BOARD_FILE_MAGIC = 0x424C4F47; // "GOLB"
+
+// Where periodic checkpoints get written (same .board format, so a crashed
+// run can be resumed - see --resume)
+const char* CHECKPOINT_PATH = "checkpoint.board";
+
+// The run-state sidecar written next to each checkpoint: a 'GOLS' magic
+// word, the generation number as two words (low half first), the
+// generations-per-frame batch size, then the viewport scale and offsets as
+// raw float bits. Together with checkpoint.board this is everything a
+// crashed run needs to pick up where it died
+const char* RUN_STATE_PATH = "checkpoint.state";
+const uint32_t RUN_STATE_MAGIC = 0x534C4F47; // "GOLS"
+
+// A recording (--record) is one stream file: a 'GOLR' magic word, the width,
+// height and capture interval, then one frame per capture - the generation
+// number as two words (low half first), followed by the packed board in the
+// usual layout. The board is already one bit per cell, so every frame is a
+// ready-made bitplane
+const uint32_t RECORDING_FILE_MAGIC = 0x524C4F47; // "GOLR"
+
 // The dimensions of the window we render to
 const int width = 800;
 const int height = 800;
 
-// The dimensions of the board we simulate
-const int gridWidth = 400;
-const int gridHeight = 400;
+// The dimensions of the board we simulate (overridable with --width / --height)
+int gridWidth = 400;
+int gridHeight = 400;
+
+// Cell state is bit-packed into 32-bit words, 32 cells per texel along a row,
+// so the textures are only gridWidth / 32 texels wide (rounded up).
+// Derived from gridWidth once the command line has been parsed
+int wordsPerRow = 0;
+
+// The workgroup dimensions declared in the app's fixed-shape compute passes
+// (census, downsample, board generation). Dispatch counts are derived from
+// these, so any board size runs at full occupancy. The kernel's own tunable
+// shape lives in the engine - see gpuEngineWorkgroupSize
+const int workgroupSize = 16;
 
 // Game state variables
 // The zoom factor for our current viewport
@@ -44,10 +181,323 @@ float currentScale = 1;
 float currentXOffset = 0;
 float currentYOffset = 0;
 
+// How fast the polled controls move: panning in board fractions per second,
+// zooming in scale units per second. Both get multiplied by the frame delta,
+// so the feel is the same at any frame rate
+const float panSpeed = 0.5f;
+const float zoomSpeed = 1.0f;
+
 // A flag determining whether or not we automatically tick the simulation forward every frame
 bool simulationIsRunning = true;
 
-GLuint computeProgram, inputTexture, outputTexture;
+// Set when T asks for a single step, consumed by the main loop on its next
+// time around - ticking straight from the key callback would land mid-frame
+bool singleStepRequested = false;
+
+// How many generations we advance per rendered frame. Rendering is capped by
+// vsync, so this is how we fast-forward well past 60 generations per second
+int generationsPerFrame = 1;
+
+// Fixed-timestep pacing (--gps): when set, the simulation targets this many
+// generations per wall-clock second whatever the monitor's refresh rate,
+// by accumulating real time into a debt of generations and running however
+// many fall due each frame. 0 = the classic per-frame batch above
+float targetGenerationsPerSecond = 0.0f;
+double generationDebt = 0.0;
+
+// Run with vsync off (--uncapped), for maximum throughput
+bool uncappedFrameRate = false;
+
+// If non-zero, run headless for this many generations and report throughput
+// instead of opening a visible window (set with --benchmark)
+int benchmarkGenerations = 0;
+
+// If non-zero, jump the board to this generation with the HashLife engine
+// at startup, before the normal tick loop takes over (set with --fastforward)
+long long fastForwardGenerations = 0;
+
+// Whether to show per-frame GPU timings in the window title. We don't have a
+// text renderer, so the title bar is our HUD
+bool showTimings = false;
+
+// Where to stream per-frame timings as CSV, if anywhere (set with --csv)
+const char* csvPath = NULL;
+
+// How many generations we've simulated since startup
+long long generationCount = 0;
+
+// Checkpointing: every checkpointInterval generations (0 = off, set with
+// --checkpoint) the board is read back asynchronously and written to disk
+int checkpointInterval = 0;
+long long lastCheckpointGeneration = 0;
+
+// Everything beyond the board itself that a resumed run needs: the
+// generation counter, the tick scheduler's batch size, and the viewport.
+// Captured at the same moment as the board readback, so both halves of a
+// checkpoint always describe the same generation
+struct RunState {
+    long long generation;
+    int generationsPerFrame;
+    float scale, xOffset, yOffset;
+};
+
+// Whether to pick up from the last checkpoint instead of the setup image
+// (--resume)
+bool resumeRun = false;
+
+// A small ring of pixel-pack buffers, so a readback can still be in flight
+// on the GPU while the simulation keeps ticking. Each slot remembers the
+// run state from the moment its readback started
+const int NUM_CHECKPOINT_PBOS = 3;
+GLuint checkpointPBOs[NUM_CHECKPOINT_PBOS];
+GLsync checkpointFences[NUM_CHECKPOINT_PBOS];
+bool checkpointInFlight[NUM_CHECKPOINT_PBOS] = { false, false, false };
+RunState checkpointPBOStates[NUM_CHECKPOINT_PBOS];
+int nextCheckpointPBO = 0;
+
+// The writer thread and the queue of finished snapshots waiting to hit disk
+struct CheckpointJob {
+    std::vector<uint32_t> board; // in the .board file layout
+    RunState state;
+};
+
+std::thread checkpointWriterThread;
+std::mutex checkpointQueueMutex;
+std::condition_variable checkpointQueueCondition;
+std::deque<CheckpointJob> checkpointQueue;
+bool checkpointWriterShouldExit = false;
+
+// The census (--census): after every generation a reduction pass counts the
+// live cells into one slot of a ring buffer that stays on the GPU. Each tick
+// batch's slots then get copied into a staging buffer and fenced, and the
+// host only reads a staging buffer once its fence says the GPU is done with
+// it - so every single generation's population gets recorded without ever
+// stalling the pipeline. (Persistently mapping the ring would save the copy,
+// but that's a 4.4 feature and we promise to run on 4.3)
+const char* censusPath = NULL;
+const int NUM_CENSUS_SLOTS = 4096;
+const int NUM_CENSUS_READBACKS = 3;
+GLuint censusBuffer;
+GLuint censusReadbackBuffers[NUM_CENSUS_READBACKS];
+int nextCensusReadback = 0;
+GLint censusSlotUniformLocation = -1;
+std::ofstream censusFile;
+
+// Ring slots are handed out in order; this counts forever and gets reduced
+// modulo the ring size when it indexes anything
+long long censusHead = 0;
+
+// One entry per flushed batch still in flight on the GPU: which staging
+// buffer holds its counts, which generations they were, and the fence that
+// says the copy has landed
+struct CensusBatch {
+    GLsync fence;
+    int readbackBuffer;
+    long long firstGeneration;
+    int count;
+};
+std::deque<CensusBatch> censusBatches;
+
+// The recorder (--record): every recordInterval generations the packed
+// board is read back through its own ring of pixel-pack buffers and
+// appended to a stream file by a writer thread, so capturing a run never
+// blocks the tick loop. When every buffer is still in flight the frame is
+// dropped (and counted) rather than stalled for
+const char* recordPath = NULL;
+int recordInterval = 0;
+long long lastRecordedGeneration = 0;
+const int NUM_RECORD_PBOS = 3;
+GLuint recordPBOs[NUM_RECORD_PBOS];
+GLsync recordFences[NUM_RECORD_PBOS];
+bool recordInFlight[NUM_RECORD_PBOS] = { false, false, false };
+long long recordPBOGenerations[NUM_RECORD_PBOS];
+int nextRecordPBO = 0;
+int oldestRecordPBO = 0;
+long long droppedRecordFrames = 0;
+
+// The recorder's writer thread and its queue of frames waiting for disk
+std::thread recordWriterThread;
+std::mutex recordQueueMutex;
+std::condition_variable recordQueueCondition;
+std::deque<std::vector<uint32_t>> recordQueue;
+bool recordWriterShouldExit = false;
+
+// Random board generation (--seed): instead of loading the setup image,
+// a compute pass hashes every cell from the seed at the given density
+bool randomizeBoard = false;
+uint32_t randomSeed = 0;
+float randomDensity = 0.5f;
+
+// The rule being played (--rule), as bitmasks over neighbour counts: bit n
+// of birthMask means a dead cell with n neighbours comes alive, bit n of
+// surviveMask means a live one stays. The masks get spliced into the kernel
+// as compile-time constants rather than read from a uniform, so every rule
+// runs at standard Life's speed. Defaults to B3/S23
+uint32_t birthMask = 1u << 3;
+uint32_t surviveMask = (1u << 2) | (1u << 3);
+
+// Interactive editing: while a mouse button is held, the cells under the
+// cursor get painted (left button) or erased (right). The edits batch up in
+// client memory and get applied once per frame by a tiny compute pass that
+// ORs / ANDs the bits into the packed board in place - no readback and no
+// full-texture re-upload, so perturbing a huge running board costs nothing
+bool paintingCells = false;
+bool erasingCells = false;
+
+// Pending edits, two words each: x (with the paint/erase flag in the top
+// bit) followed by y
+std::vector<uint32_t> pendingEdits;
+
+// The last cell painted this stroke, so fast drags can be filled in as a
+// line instead of a trail of disconnected dots (-1 = no stroke in progress)
+int lastEditCellX = -1, lastEditCellY = -1;
+
+// The SSBO the pending edits are streamed through
+GLuint editBuffer;
+GLint numEditsUniformLocation = -1;
+
+// The app's own compute passes - the kernel and the sparse scheduler belong
+// to the engine now
+GLuint populationProgram, downsampleProgram, generateProgram, editProgram;
+
+// The renderer's private copy of the board. simulationTick publishes each
+// frame's final generation into it with one small copy, so the draw never
+// samples a texture the kernel might still be writing - which lets a
+// frame's compute work overlap the previous frame's rasterization on the
+// GPU instead of the two serializing behind a texture-fetch barrier
+GLuint displayBoardTexture;
+
+// Whether we're simulating on the CPU instead of with compute shaders -
+// either forced with --cpu, or because the driver can't give us OpenGL 4.3
+bool useCpuEngine = false;
+
+// Whether the CPU engine's board has advanced since we last uploaded it to
+// the display texture
+bool cpuBoardDirty = true;
+
+// Sparse simulation (--sparse): the kernel flags tiles whose cells changed,
+// and the engine's scheduler pass turns last generation's flags into an
+// indirect dispatch covering only the tiles that could possibly change this
+// one
+bool sparseMode = false;
+
+// Partitioned simulation (--partitions): the board is carved into horizontal
+// bands, each simulated by its own worker thread on its own GL context
+// (sharing objects with the main one). Every band keeps its rows plus a
+// one-row halo above and below in its own pair of ping-pong textures, and
+// the main thread copies the halo strips between neighbours each generation
+int numPartitions = 1;
+
+struct Partition {
+    GLFWwindow* window;  // hidden window owning this band's context
+    std::thread thread;
+    GLuint textures[2];  // the band's rows plus halos, ping-ponged
+    GLsync fence;        // signalled when the band's latest dispatch is queued
+    int firstRow;        // the band's first board row
+    int numRows;         // how many board rows the band covers
+};
+std::vector<Partition> partitions;
+
+// Which of each band's textures holds the latest generation
+int bandLatest = 0;
+
+// The handshake between the main thread and the band workers: the main
+// thread bumps partitionGeneration to start a generation, and the workers
+// count themselves into partitionsDone once their dispatches are queued
+std::mutex partitionMutex;
+std::condition_variable partitionCondition;
+int partitionGeneration = 0;
+int partitionsDone = 0;
+bool partitionsShouldExit = false;
+
+// Signalled by the main thread once a generation's halo exchange is queued,
+// so the workers order their next halo reads behind it
+GLsync partitionExchangeFence = NULL;
+
+// What lies past the edges of the board (--boundary):
+// 0 = dead cells, 1 = toroidal wrap, 2 = reflective mirror
+int boundaryMode = 0;
+
+// The coarse overview for zoomed-out rendering (GPU path only): one texel
+// per 32x32 block of cells, set if anything in the block is alive. It's
+// rebuilt by a downsample pass at most once per frame, and only while the
+// render path is actually using it
+GLuint coarseTexture;
+int coarseHeight = 0;
+GLint useCoarseUniformLocation = -1;
+long long lastCoarseGeneration = -1;
+
+// Switch to the overview once a pixel covers at least this many cells -
+// at 32 a pixel spans a whole coarse block, so nothing visible is lost
+const float coarseCellsPerPixel = 32.0f;
+
+// The age heatmap view (toggled with H, GPU path only): the kernel keeps a
+// byte of per-cell age in the engine's age texture while the view is on,
+// and the fragment shader maps it through a palette
+bool ageHeatmap = false;
+
+// The generation history ring (--history, GPU dense mode only): the last
+// historyDepth generations get copied into layers of one texture array as
+// they're produced, still bit-packed, so rewinding costs no readback and a
+// layer is only a 32nd of the board in texels. Left/Right step the view
+// back and forward through the ring, and F toggles a diff view against the
+// generation before the one on screen
+int historyDepth = 0;
+GLuint historyTexture = 0;
+
+// How many generations have been stored so far - the newest lives in layer
+// (historyHead - 1) % historyDepth - and which generation each layer holds
+long long historyHead = 0;
+std::vector<long long> historyGenerations;
+
+// How far back the view currently is (0 = live), and whether the diff
+// view is on
+int rewindOffset = 0;
+bool diffView = false;
+GLint historyLayerUniformLocation = -1;
+GLint diffLayerUniformLocation = -1;
+
+// Convergence detection (--detect <k>): after each tick batch, compare
+// passes check the live board against the last k stored generations. A
+// match means the board has settled into a still life or an oscillator of
+// that period, so the main loop can pause - or a benchmark can stop early -
+// instead of burning GPU time on a board that's finished changing. Works
+// through the history ring, so it shares its single-context GPU requirement
+int detectMaxPeriod = 0;
+GLuint compareProgram = 0;
+GLuint detectionBuffer = 0, detectionReadbackBuffer = 0;
+GLint flagSlotUniformLocation = -1;
+
+// The probe in flight (one at a time): the fence guarding its staged flags,
+// how many periods it actually tested, and the generation it examined.
+// detectedPeriod holds the latest verdict - the shortest cycle found, or
+// zero while the board is still changing
+GLsync detectionFence = NULL;
+int detectionProbedPeriods = 0;
+long long detectionGeneration = 0;
+int detectedPeriod = 0;
+bool convergenceAnnounced = false;
+
+// Region-of-interest mode (R, GPU single-context only): simulate only the
+// tiles under the viewport plus a small fixed margin, while the rest of
+// the board holds still at the generation R was pressed. The view is an
+// approximation - the cells just inside the margin border on frozen
+// neighbours, so staleness creeps inward at one cell per generation and
+// can reach the screen once the margin is used up. Handy for cheaply
+// poking at one corner of a huge board when near enough is good enough.
+// Pressing R again resumes the full board, with the frozen region simply
+// carrying on from where it stopped
+bool roiMode = false;
+
+// How many cells of breathing room to thaw around the viewport
+const int roiMargin = 64;
+
+// Transitions get handled at the next tick, where the GL work belongs:
+// entering mirrors the board across the ping-pong pair (so the tiles ROI
+// never dispatches read identically from either), leaving wakes every tile
+// so the sparse scheduler re-examines the thawed region
+bool roiSyncPending = false;
+bool roiWakePending = false;
 
 // The vertices and UV coordinates of a quad
 // Used to render the game state texture to the screen
@@ -67,95 +517,979 @@ static void errorCallback(int error, const char* description)
     fprintf(stderr, "Error: %s\n", description);
 }
 
-GLuint loadCompileShader(const char* shaderPath, GLenum shaderType)
+// The live mapping of the board file, if there is one, so we can unmap it
+// once the texture upload has taken its copy
+#ifdef _WIN32
+static HANDLE boardFileHandle = INVALID_HANDLE_VALUE;
+static HANDLE boardMappingHandle = NULL;
+#else
+static size_t boardMappingSize = 0;
+#endif
+static void* boardMapping = NULL;
+
+// Try to memory-map a packed .board file. Returns a pointer to the packed
+// cell words on success (call unmapBoardFile once they've been uploaded), or
+// NULL if the file doesn't exist or doesn't match the configured board size
+uint32_t* mapBoardFile(const char* path)
 {
-    // Load in our shader code
-    std::string shaderSource;
-    std::ifstream shaderFile;
+    size_t expectedSize = (3 + (size_t)wordsPerRow * gridHeight) * sizeof(uint32_t);
+
+#ifdef _WIN32
+    boardFileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (boardFileHandle == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(boardFileHandle, &fileSize) || (size_t)fileSize.QuadPart != expectedSize) {
+        std::cerr << "Board file has the wrong size for a " << gridWidth << " x " << gridHeight << " board!" << std::endl;
+        CloseHandle(boardFileHandle);
+        boardFileHandle = INVALID_HANDLE_VALUE;
+        return NULL;
+    }
 
-    // Make sure an exception will be thrown if an error occurs
-    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+    boardMappingHandle = CreateFileMappingA(boardFileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    boardMapping = boardMappingHandle ? MapViewOfFile(boardMappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return NULL;
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || (size_t)fileInfo.st_size != expectedSize) {
+        std::cerr << "Board file has the wrong size for a " << gridWidth << " x " << gridHeight << " board!" << std::endl;
+        close(fd);
+        return NULL;
+    }
 
-    try
-    {
-        // Open the file, and read in the source to a stream
-        shaderFile.open(shaderPath);
-        std::stringstream shaderSourceStream;
-        shaderSourceStream << shaderFile.rdbuf();
-        
-        // Close the file, and convert to a std::string
-        shaderFile.close();
-        shaderSource = shaderSourceStream.str();
+    boardMappingSize = expectedSize;
+    boardMapping = mmap(NULL, expectedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (boardMapping == MAP_FAILED)
+        boardMapping = NULL;
+
+    // The mapping keeps its own reference to the file
+    close(fd);
+#endif
+
+    if (boardMapping == NULL)
+        return NULL;
+
+    // Sanity-check the header against what we expect to be simulating
+    uint32_t* header = (uint32_t*)boardMapping;
+    if (header[0] != BOARD_FILE_MAGIC || header[1] != (uint32_t)gridWidth || header[2] != (uint32_t)gridHeight) {
+        std::cerr << "Board file has the wrong magic or dimensions!" << std::endl;
+        return NULL;
     }
-    catch (std::ifstream::failure e)
-    {
-        std::cerr << "Couldn't load " << shaderPath << std::endl;
-        return -1;
+
+    // The packed cell words start right after the header
+    return header + 3;
+}
+
+void unmapBoardFile()
+{
+#ifdef _WIN32
+    UnmapViewOfFile(boardMapping);
+    CloseHandle(boardMappingHandle);
+    CloseHandle(boardFileHandle);
+#else
+    munmap(boardMapping, boardMappingSize);
+#endif
+    boardMapping = NULL;
+}
+
+// Retire any census batches whose fences have signalled: read their counts
+// out of the staging buffers and stream them to the CSV. With wait set,
+// block on the oldest batch instead of giving up - used when every staging
+// buffer is in flight and the tick loop needs one back
+void pumpCensusReadbacks(bool wait)
+{
+    while (!censusBatches.empty()) {
+        CensusBatch& batch = censusBatches.front();
+
+        // Let the first wait flush the command queue: an unflushed fence is
+        // never guaranteed to signal, so without this the blocking drains
+        // could spin on a fence the GPU hasn't even been told about yet
+        GLbitfield flushFlag = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+        while (true) {
+            GLenum state = glClientWaitSync(batch.fence, flushFlag, wait ? 1000000000ull : 0);
+            flushFlag = 0;
+
+            if (state == GL_ALREADY_SIGNALED || state == GL_CONDITION_SATISFIED)
+                break;
+            if (!wait)
+                return;
+        }
+
+        // Nothing else touches this staging buffer until the batch retires,
+        // so with the fence signalled this read can't stall
+        std::vector<uint32_t> counts(batch.count);
+        glBindBuffer(GL_COPY_READ_BUFFER, censusReadbackBuffers[batch.readbackBuffer]);
+        glGetBufferSubData(GL_COPY_READ_BUFFER, 0, batch.count * sizeof(uint32_t), counts.data());
+        glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+        for (int i = 0; i < batch.count; i++)
+            censusFile << (batch.firstGeneration + i) << "," << counts[i] << "\n";
+
+        glDeleteSync(batch.fence);
+        censusBatches.pop_front();
     }
+}
 
-    // From a std::string to a C string
-    const char* shaderSourceString = shaderSource.c_str();
+// Queue a finished batch of census slots out of the ring into a staging
+// buffer, and fence the copy so the host knows when it can read it. The
+// ring slots themselves are reusable as soon as the copy is queued - GPU
+// commands run in order, so any later re-zeroing lands after the copy
+void flushCensusBatch(long long firstGeneration, long long firstSlot, int count)
+{
+    // The staging buffers recycle in order, so when they're all in flight
+    // the oldest batch has to retire before this one can stage
+    if ((int)censusBatches.size() == NUM_CENSUS_READBACKS)
+        pumpCensusReadbacks(true);
 
-    // Create & compile a new shader
-    GLuint shader = glCreateShader(shaderType);
-    glShaderSource(shader, 1, &shaderSourceString, NULL);
-    glCompileShader(shader);
-    
-    int success;
-    char infoLog[512];
-    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+    CensusBatch batch;
+    batch.readbackBuffer = nextCensusReadback;
+    batch.firstGeneration = firstGeneration;
+    batch.count = count;
+    nextCensusReadback = (nextCensusReadback + 1) % NUM_CENSUS_READBACKS;
 
-    if (!success)
-    {
-        glGetShaderInfoLog(shader, 512, NULL, infoLog);
-        std::cerr << "Shader compilation error in " << shaderPath << " :\n" << infoLog << std::endl;
-        return -1;
+    // Make the reduction's atomics visible to the copy, then stage the
+    // batch's slots (in two pieces if they wrap the ring)
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+
+    glBindBuffer(GL_COPY_READ_BUFFER, censusBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, censusReadbackBuffers[batch.readbackBuffer]);
+
+    int slot = (int)(firstSlot % NUM_CENSUS_SLOTS);
+    int firstPiece = std::min(count, NUM_CENSUS_SLOTS - slot);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, slot * sizeof(uint32_t), 0, firstPiece * sizeof(uint32_t));
+
+    if (firstPiece < count)
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, firstPiece * sizeof(uint32_t), (count - firstPiece) * sizeof(uint32_t));
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    batch.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    censusBatches.push_back(batch);
+}
+
+// Runs on its own thread, one per band: waits for the main thread to start
+// a generation, then dispatches the kernel over its band on its own context.
+// The band textures carry the halo rows, so the dispatch covers them too -
+// the values computed there are nonsense, but the halo exchange overwrites
+// them before anyone reads them
+void partitionWorkerMain(int index)
+{
+    Partition& partition = partitions[index];
+    glfwMakeContextCurrent(partition.window);
+
+    int lastGeneration = 0;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(partitionMutex);
+            partitionCondition.wait(lock, [&] { return partitionsShouldExit || partitionGeneration != lastGeneration; });
+
+            if (partitionsShouldExit)
+                break;
+
+            lastGeneration = partitionGeneration;
+        }
+
+        // Don't read the halo rows until the previous generation's exchange
+        // has been queued ahead of us
+        glWaitSync(partitionExchangeFence, 0, GL_TIMEOUT_IGNORED);
+
+        glUseProgram(gpuEngineKernelProgram());
+        glBindImageTexture(0, partition.textures[bandLatest], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+        glBindImageTexture(1, partition.textures[1 - bandLatest], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+        glBindImageTexture(2, gpuEngineAgeTexture(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_R8UI);
+
+        // The kernel unconditionally flags changed tiles; point it at the
+        // engine's activity buffer even though nothing reads the flags here
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, gpuEngineActivityBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, gpuEngineTileListBuffer());
+
+        int kernelWorkgroupSize = gpuEngineWorkgroupSize();
+        glDispatchCompute((GLuint)(wordsPerRow + kernelWorkgroupSize - 1) / kernelWorkgroupSize,
+                          (GLuint)(partition.numRows + 2 + kernelWorkgroupSize - 1) / kernelWorkgroupSize, 1);
+
+        // Make the image stores visible to the main context's halo copies,
+        // and give it a fence to queue those copies behind
+        glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT | GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+
+        if (partition.fence != NULL)
+            glDeleteSync(partition.fence);
+        partition.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        {
+            std::lock_guard<std::mutex> lock(partitionMutex);
+            partitionsDone++;
+        }
+        partitionCondition.notify_all();
     }
 
-    return shader;
+    glfwMakeContextCurrent(NULL);
 }
 
-GLuint createLinkProgram(GLuint shaders[], unsigned int numShaders)
+// The main thread's half of partitioned simulation: start the band workers
+// on a generation, wait for their dispatches, then exchange the halo strips
+// between neighbouring bands
+void partitionedTick(int generations)
 {
-    GLuint program = glCreateProgram();
+    for (int i = 0; i < generations; i++) {
+        // Kick every band worker off on one generation
+        {
+            std::lock_guard<std::mutex> lock(partitionMutex);
+            partitionsDone = 0;
+            partitionGeneration++;
+        }
+        partitionCondition.notify_all();
+
+        // Wait until they've all queued their dispatches
+        {
+            std::unique_lock<std::mutex> lock(partitionMutex);
+            partitionCondition.wait(lock, [] { return partitionsDone == numPartitions; });
+        }
+
+        // Queue our halo copies behind every band's dispatch
+        for (const Partition& partition : partitions)
+            glWaitSync(partition.fence, 0, GL_TIMEOUT_IGNORED);
+
+        int output = 1 - bandLatest;
+
+        for (int p = 0; p < numPartitions; p++) {
+            // A band's first real row is the band below's top halo, and its
+            // last real row is the band above's bottom halo
+            if (p > 0)
+                glCopyImageSubData(partitions[p].textures[output], GL_TEXTURE_2D, 0, 0, 1, 0,
+                                   partitions[p - 1].textures[output], GL_TEXTURE_2D, 0, 0, partitions[p - 1].numRows + 1, 0,
+                                   wordsPerRow, 1, 1);
+
+            if (p < numPartitions - 1)
+                glCopyImageSubData(partitions[p].textures[output], GL_TEXTURE_2D, 0, 0, partitions[p].numRows, 0,
+                                   partitions[p + 1].textures[output], GL_TEXTURE_2D, 0, 0, 0, 0,
+                                   wordsPerRow, 1, 1);
+        }
+
+        // The outermost halo rows hang off the edge of the board and must
+        // stay dead - the dispatch scribbled on them, so put the zeroes back
+        static std::vector<uint32_t> deadRow;
+        deadRow.assign(wordsPerRow, 0);
+
+        glBindTexture(GL_TEXTURE_2D, partitions[0].textures[output]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, wordsPerRow, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, deadRow.data());
+        glBindTexture(GL_TEXTURE_2D, partitions[numPartitions - 1].textures[output]);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, partitions[numPartitions - 1].numRows + 1, wordsPerRow, 1, GL_RED_INTEGER, GL_UNSIGNED_INT, deadRow.data());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        // Fence the exchange so next generation's halo reads queue behind it
+        if (partitionExchangeFence != NULL)
+            glDeleteSync(partitionExchangeFence);
+        partitionExchangeFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        glFlush();
+
+        bandLatest = 1 - bandLatest;
+    }
 
-    // Attach all of the shaders we've been given to the new program
-    for (unsigned int i = 0; i < numShaders; i++)
+    // Gather the bands into the display texture, so rendering and the
+    // checkpoint readback see one assembled board
+    for (const Partition& partition : partitions)
+        glCopyImageSubData(partition.textures[bandLatest], GL_TEXTURE_2D, 0, 0, 1, 0,
+                           gpuEngineBoardTexture(), GL_TEXTURE_2D, 0, 0, partition.firstRow, 0,
+                           wordsPerRow, partition.numRows, 1);
+
+    generationCount += generations;
+}
+
+// Stop the band workers and destroy their contexts
+void shutdownPartitions()
+{
     {
-        glAttachShader(program, shaders[i]);
+        std::lock_guard<std::mutex> lock(partitionMutex);
+        partitionsShouldExit = true;
+    }
+    partitionCondition.notify_all();
+
+    for (Partition& partition : partitions) {
+        partition.thread.join();
+        glfwDestroyWindow(partition.window);
+    }
+}
+
+// Publish the latest generation into the renderer's copy of the board. The
+// draw samples only this copy, so the only ordering between simulation and
+// rendering is this one small texture-to-texture copy
+void publishDisplayBoard()
+{
+    // Headless benchmark runs never draw, so there's nothing to publish
+    if (benchmarkGenerations > 0)
+        return;
+
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glCopyImageSubData(gpuEngineBoardTexture(), GL_TEXTURE_2D, 0, 0, 0, 0,
+                       displayBoardTexture, GL_TEXTURE_2D, 0, 0, 0, 0,
+                       wordsPerRow, gridHeight, 1);
+}
+
+// Kick off a convergence probe against the generation just produced: one
+// compare dispatch per candidate period, each reading the live board against
+// the history layer that many generations back. The flags are staged into a
+// little readback buffer behind a fence, so nothing here ever stalls -
+// pumpDetectionProbe collects the verdict once the GPU is safely past it
+void startDetectionProbe()
+{
+    // One probe in flight at a time - if the last one is still working its
+    // way down the pipe, this batch just goes unexamined
+    if (detectionFence != NULL)
+        return;
+
+    // The ring has to actually reach back p generations before period p is
+    // testable (its newest layer is the live board itself)
+    long long available = std::min(historyHead, (long long)historyDepth);
+    int testablePeriods = (int)std::min((long long)detectMaxPeriod, available - 1);
+
+    if (testablePeriods < 1)
+        return;
+
+    // Every flag starts at zero, meaning "identical so far"
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, detectionBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glUseProgram(compareProgram);
+    glBindImageTexture(0, gpuEngineBoardTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, detectionBuffer);
+
+    for (int period = 1; period <= testablePeriods; period++) {
+        // The newest stored layer duplicates the live board (offset zero),
+        // so the generation period steps back sits that many layers behind
+        // the head
+        int layer = (int)((historyHead - 1 - period) % historyDepth);
+
+        glUniform1i(flagSlotUniformLocation, period - 1);
+        glBindImageTexture(1, historyTexture, 0, GL_FALSE, layer, GL_READ_ONLY, GL_R32UI);
+        glDispatchCompute((GLuint)(wordsPerRow + workgroupSize - 1) / workgroupSize,
+                          (GLuint)(gridHeight + workgroupSize - 1) / workgroupSize, 1);
     }
 
-    // Link all of our shaders together
-    glLinkProgram(program);
+    // Make the probes' flag stores visible to the copy - the consumer here
+    // is glCopyBufferSubData, so it's the buffer-update bit that orders it,
+    // not the storage bit - then stage the flags for the host and fence the
+    // lot
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, detectionBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, detectionReadbackBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, (size_t)detectMaxPeriod * sizeof(uint32_t));
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    detectionFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    detectionProbedPeriods = testablePeriods;
+    detectionGeneration = generationCount;
+}
+
+// Collect a finished probe's verdict, if one is ready - or wait for it, when
+// the benchmark wants an answer before deciding on its next chunk
+void pumpDetectionProbe(bool wait)
+{
+    if (detectionFence == NULL)
+        return;
+
+    // As with the census fences, the first wait flushes the queue - an
+    // unflushed fence might otherwise never signal
+    GLbitfield flushFlag = GL_SYNC_FLUSH_COMMANDS_BIT;
 
-    int success;
-    char infoLog[512];
+    while (true) {
+        GLenum state = glClientWaitSync(detectionFence, flushFlag, wait ? 1000000000ull : 0);
+        flushFlag = 0;
 
-    glGetProgramiv(program, GL_LINK_STATUS, &success);
-    if (!success) {
-        glGetProgramInfoLog(program, 512, NULL, infoLog);
-        std::cout << "Shader link error:\n" << infoLog << std::endl;
+        if (state == GL_ALREADY_SIGNALED || state == GL_CONDITION_SATISFIED)
+            break;
+        if (!wait)
+            return;
     }
 
-    return program;
+    glDeleteSync(detectionFence);
+    detectionFence = NULL;
+
+    // The fence has signalled, so this read can't stall
+    std::vector<uint32_t> flags(detectMaxPeriod);
+    glBindBuffer(GL_COPY_READ_BUFFER, detectionReadbackBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, (size_t)detectMaxPeriod * sizeof(uint32_t), flags.data());
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    // An untouched flag means that period's generations matched exactly.
+    // Only the periods actually probed count - the rest were merely zeroed
+    detectedPeriod = 0;
+
+    for (int period = 1; period <= detectionProbedPeriods; period++) {
+        if (flags[period - 1] == 0) {
+            detectedPeriod = period;
+            break;
+        }
+    }
 }
 
-void simulationTick()
+void simulationTick(int generations)
 {
-    // Generate a texture using the compute shader
-    glUseProgram(computeProgram);
+    // On machines without compute shaders the whole update runs on the CPU,
+    // and the result only gets uploaded when a frame is actually rendered
+    if (useCpuEngine) {
+        cpuEngineTick(generations);
+        cpuBoardDirty = true;
+        generationCount += generations;
+        return;
+    }
+
+    // In partitioned mode the band workers do the simulating - the main
+    // thread just conducts
+    if (numPartitions > 1) {
+        partitionedTick(generations);
+        publishDisplayBoard();
+        return;
+    }
+
+    // ROI transitions, deferred from the key callback to here
+    if (roiSyncPending) {
+        // Mirror the live board across the engine's ping-pong pair, so the
+        // frozen region reads the same from whichever texture is current
+        gpuEngineMirrorBoard();
+
+        roiSyncPending = false;
+    }
+
+    if (roiWakePending) {
+        // Back to the full board: every tile might be stale, so wake the
+        // lot and let the scheduler sort things out from scratch
+        gpuEngineWakeAllTiles();
+
+        roiWakePending = false;
+    }
+
+    // Where this call's census slots start, for the flush at the end
+    long long censusBatchFirstSlot = censusHead;
+    long long censusBatchFirstGeneration = generationCount + 1;
+    int censusBatchCount = 0;
+
+    for (int i = 0; i < generations; i++) {
+        if (roiMode) {
+            // Just the tiles covering the viewport, plus the fixed margin.
+            // The cells at the margin's border read frozen neighbours, so
+            // staleness bleeds inward a cell a generation - on-screen cells
+            // are only trustworthy for the margin's width in generations
+            float viewExtent = 1.0f / currentScale;
+
+            int firstCellX = (int)std::floor(currentXOffset * gridWidth) - roiMargin;
+            int lastCellX = (int)std::ceil((currentXOffset + viewExtent) * gridWidth) + roiMargin;
+            int firstCellY = (int)std::floor(currentYOffset * gridHeight) - roiMargin;
+            int lastCellY = (int)std::ceil((currentYOffset + viewExtent) * gridHeight) + roiMargin;
+
+            // Clamp to the board before dividing - negative cell coordinates
+            // would round the wrong way
+            int kernelWorkgroupSize = gpuEngineWorkgroupSize();
+            int firstTileX = std::max(firstCellX, 0) / (32 * kernelWorkgroupSize);
+            int lastTileX = std::min(std::max(lastCellX, 0) / 32, wordsPerRow - 1) / kernelWorkgroupSize;
+            int firstTileY = std::max(firstCellY, 0) / kernelWorkgroupSize;
+            int lastTileY = std::min(std::max(lastCellY, 0), gridHeight - 1) / kernelWorkgroupSize;
+
+            gpuEngineStepRegion(firstTileX, firstTileY, lastTileX, lastTileY, ageHeatmap);
+        }
+        else {
+            gpuEngineStep(sparseMode, ageHeatmap);
+        }
+
+        // File the new generation in the history ring, overwriting the
+        // oldest layer
+        if (historyDepth > 0) {
+            int layer = (int)(historyHead % historyDepth);
+
+            glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+            glCopyImageSubData(gpuEngineBoardTexture(), GL_TEXTURE_2D, 0, 0, 0, 0,
+                               historyTexture, GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer,
+                               wordsPerRow, gridHeight, 1);
+
+            historyGenerations[layer] = generationCount + i + 1;
+            historyHead++;
+        }
+
+        // Census: reduce the generation we just produced into the next ring
+        // slot. The image barrier above already covers the pass's reads
+        if (censusFile.is_open()) {
+            // Flush over-long batches early, so a slot never wraps onto
+            // itself within one batch
+            if (censusBatchCount == NUM_CENSUS_SLOTS) {
+                flushCensusBatch(censusBatchFirstGeneration, censusBatchFirstSlot, censusBatchCount);
+                censusBatchFirstGeneration += censusBatchCount;
+                censusBatchFirstSlot = censusHead;
+                censusBatchCount = 0;
+            }
+
+            int slot = (int)(censusHead % NUM_CENSUS_SLOTS);
+            censusHead++;
+            censusBatchCount++;
+
+            // Zero the slot, then let every workgroup add its total in
+            GLuint zero = 0;
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, censusBuffer);
+            glBufferSubData(GL_SHADER_STORAGE_BUFFER, slot * sizeof(uint32_t), sizeof(uint32_t), &zero);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+            glUseProgram(populationProgram);
+            glUniform1i(censusSlotUniformLocation, slot);
+            glBindImageTexture(0, gpuEngineBoardTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, censusBuffer);
+
+            // The census pass keeps its own fixed workgroup shape, so its
+            // dispatch counts don't follow the kernel's tile grid
+            glDispatchCompute((GLuint)(wordsPerRow + workgroupSize - 1) / workgroupSize,
+                              (GLuint)(gridHeight + workgroupSize - 1) / workgroupSize, 1);
+        }
+    }
+
+    if (censusBatchCount > 0)
+        flushCensusBatch(censusBatchFirstGeneration, censusBatchFirstSlot, censusBatchCount);
+
+    // Hand the finished generation over to the renderer's copy
+    publishDisplayBoard();
 
-    // Run the compute shader!
-    glDispatchCompute((GLuint)gridWidth, (GLuint)gridHeight, 1);
+    generationCount += generations;
+
+    // With the whole batch on the queue, this is the moment to ask whether
+    // the board is still actually changing
+    if (detectMaxPeriod > 0)
+        startDetectionProbe();
+}
+
+// Runs on its own thread: takes finished board snapshots off the queue and
+// writes them to disk, so file IO never stalls the tick loop
+void checkpointWriterMain()
+{
+    while (true) {
+        CheckpointJob job;
+
+        {
+            std::unique_lock<std::mutex> lock(checkpointQueueMutex);
+            checkpointQueueCondition.wait(lock, [] { return !checkpointQueue.empty() || checkpointWriterShouldExit; });
+
+            // Asked to exit, and everything pending has been written
+            if (checkpointQueue.empty())
+                break;
+
+            job = std::move(checkpointQueue.front());
+            checkpointQueue.pop_front();
+        }
+
+        // Write to a temporary file first and then swap it into place, so a
+        // crash mid-write can't destroy the previous checkpoint
+        std::string tempPath = std::string(CHECKPOINT_PATH) + ".tmp";
+        std::ofstream checkpointFile(tempPath, std::ios::binary | std::ios::trunc);
+        checkpointFile.write((const char*)job.board.data(), job.board.size() * sizeof(uint32_t));
+        checkpointFile.close();
+
+        std::remove(CHECKPOINT_PATH);
+        std::rename(tempPath.c_str(), CHECKPOINT_PATH);
+
+        // The run-state sidecar follows the board, same atomic-swap dance
+        uint32_t stateWords[7];
+        stateWords[0] = RUN_STATE_MAGIC;
+        stateWords[1] = (uint32_t)(job.state.generation & 0xFFFFFFFF);
+        stateWords[2] = (uint32_t)(job.state.generation >> 32);
+        stateWords[3] = (uint32_t)job.state.generationsPerFrame;
+        std::memcpy(&stateWords[4], &job.state.scale, sizeof(float));
+        std::memcpy(&stateWords[5], &job.state.xOffset, sizeof(float));
+        std::memcpy(&stateWords[6], &job.state.yOffset, sizeof(float));
+
+        std::string stateTempPath = std::string(RUN_STATE_PATH) + ".tmp";
+        std::ofstream stateFile(stateTempPath, std::ios::binary | std::ios::trunc);
+        stateFile.write((const char*)stateWords, sizeof(stateWords));
+        stateFile.close();
+
+        std::remove(RUN_STATE_PATH);
+        std::rename(stateTempPath.c_str(), RUN_STATE_PATH);
+    }
+}
+
+// The run state as it stands right now, for pairing with a board snapshot
+RunState captureRunState()
+{
+    RunState state;
+    state.generation = generationCount;
+    state.generationsPerFrame = generationsPerFrame;
+    state.scale = currentScale;
+    state.xOffset = currentXOffset;
+    state.yOffset = currentYOffset;
+    return state;
+}
+
+// Kick off an asynchronous readback of the latest board into the next free
+// pixel-pack buffer. The disk write happens later, once the GPU signals that
+// the copy has finished
+void startCheckpointReadback()
+{
+    int slot = nextCheckpointPBO;
+
+    // If every buffer in the ring is still in flight, skip this checkpoint
+    // rather than stall the tick loop waiting for one to free up
+    if (checkpointInFlight[slot])
+        return;
+
+    // With a pack buffer bound, glGetTexImage becomes an asynchronous
+    // GPU-to-buffer copy instead of a blocking read to client memory
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, checkpointPBOs[slot]);
+    glBindTexture(GL_TEXTURE_2D, gpuEngineBoardTexture());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    // The fence tells us when the copy is actually done. The run state is
+    // captured now, while it still matches the board being read back
+    checkpointFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    checkpointInFlight[slot] = true;
+    checkpointPBOStates[slot] = captureRunState();
+    nextCheckpointPBO = (slot + 1) % NUM_CHECKPOINT_PBOS;
+}
+
+// See whether any in-flight readbacks have finished, and hand completed
+// snapshots over to the writer thread. Never blocks - buffers that aren't
+// done yet just get checked again next frame
+void pumpCheckpointReadbacks()
+{
+    for (int slot = 0; slot < NUM_CHECKPOINT_PBOS; slot++) {
+        if (!checkpointInFlight[slot])
+            continue;
+
+        GLenum status = glClientWaitSync(checkpointFences[slot], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            continue;
+
+        glDeleteSync(checkpointFences[slot]);
+
+        // The copy is done, so mapping the buffer won't stall
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, checkpointPBOs[slot]);
+        uint32_t* words = (uint32_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (size_t)wordsPerRow * gridHeight * sizeof(uint32_t), GL_MAP_READ_BIT);
+
+        if (words != NULL) {
+            // Package the snapshot up in the .board file layout, paired with
+            // the run state captured when the readback started
+            CheckpointJob job;
+            job.board.resize(3 + (size_t)wordsPerRow * gridHeight);
+            job.board[0] = BOARD_FILE_MAGIC;
+            job.board[1] = (uint32_t)gridWidth;
+            job.board[2] = (uint32_t)gridHeight;
+            std::copy(words, words + (size_t)wordsPerRow * gridHeight, job.board.begin() + 3);
+            job.state = checkpointPBOStates[slot];
+
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+            {
+                std::lock_guard<std::mutex> lock(checkpointQueueMutex);
+                checkpointQueue.push_back(std::move(job));
+            }
+            checkpointQueueCondition.notify_one();
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        checkpointInFlight[slot] = false;
+    }
+}
+
+// Runs on its own thread: appends finished frames to the recording stream
+// in capture order, so file IO never slows the tick loop down
+void recordWriterMain()
+{
+    // One stream for the whole run, headed so it's self-describing
+    std::ofstream recordFile(recordPath, std::ios::binary | std::ios::trunc);
+    uint32_t header[4] = { RECORDING_FILE_MAGIC, (uint32_t)gridWidth, (uint32_t)gridHeight, (uint32_t)recordInterval };
+    recordFile.write((const char*)header, sizeof(header));
+
+    while (true) {
+        std::vector<uint32_t> frame;
+
+        {
+            std::unique_lock<std::mutex> lock(recordQueueMutex);
+            recordQueueCondition.wait(lock, [] { return !recordQueue.empty() || recordWriterShouldExit; });
+
+            // Asked to exit, and every pending frame has been written
+            if (recordQueue.empty())
+                break;
+
+            frame = std::move(recordQueue.front());
+            recordQueue.pop_front();
+        }
+
+        recordFile.write((const char*)frame.data(), frame.size() * sizeof(uint32_t));
+    }
+}
+
+// Kick off an asynchronous readback of the latest board into the next free
+// recording buffer, or drop the frame if the whole ring is still in flight -
+// a gap in the recording beats stalling the simulation
+void startRecordReadback()
+{
+    int slot = nextRecordPBO;
+
+    if (recordInFlight[slot]) {
+        droppedRecordFrames++;
+        return;
+    }
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, recordPBOs[slot]);
+    glBindTexture(GL_TEXTURE_2D, gpuEngineBoardTexture());
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, (void*)0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    recordFences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    recordPBOGenerations[slot] = generationCount;
+    recordInFlight[slot] = true;
+    nextRecordPBO = (slot + 1) % NUM_RECORD_PBOS;
+}
+
+// Hand any finished readbacks to the writer thread. Unlike the checkpoint
+// pump this retires the ring strictly oldest-first, since frames have to
+// land in the stream in capture order
+void pumpRecordReadbacks()
+{
+    while (recordInFlight[oldestRecordPBO]) {
+        int slot = oldestRecordPBO;
+
+        GLenum status = glClientWaitSync(recordFences[slot], 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+            break;
+
+        glDeleteSync(recordFences[slot]);
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, recordPBOs[slot]);
+        uint32_t* words = (uint32_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (size_t)wordsPerRow * gridHeight * sizeof(uint32_t), GL_MAP_READ_BIT);
+
+        if (words != NULL) {
+            std::vector<uint32_t> frame(2 + (size_t)wordsPerRow * gridHeight);
+            frame[0] = (uint32_t)(recordPBOGenerations[slot] & 0xFFFFFFFF);
+            frame[1] = (uint32_t)(recordPBOGenerations[slot] >> 32);
+            std::copy(words, words + (size_t)wordsPerRow * gridHeight, frame.begin() + 2);
+
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+
+            {
+                std::lock_guard<std::mutex> lock(recordQueueMutex);
+                recordQueue.push_back(std::move(frame));
+            }
+            recordQueueCondition.notify_one();
+        }
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        recordInFlight[slot] = false;
+        oldestRecordPBO = (slot + 1) % NUM_RECORD_PBOS;
+    }
+}
+
+// A pattern decoded from a Run Length Encoded (.rle) file - the standard
+// interchange format for Game of Life patterns
+struct RLEPattern {
+    int width = 0;
+    int height = 0;
+
+    // One byte per cell, row by row, top row first
+    std::vector<uint8_t> cells;
+};
+
+// Parse an RLE pattern file. Returns false (with a message) if the file
+// can't be read or doesn't look like RLE
+bool loadRLEPattern(const char* path, RLEPattern& pattern)
+{
+    std::ifstream patternFile(path);
+
+    if (!patternFile) {
+        std::cerr << "Couldn't load pattern " << path << std::endl;
+        return false;
+    }
+
+    // Skip any #-comment lines; the first real line is the header,
+    // "x = <width>, y = <height>" (optionally followed by a rule we ignore)
+    std::string line;
+    while (std::getline(patternFile, line)) {
+        if (!line.empty() && line[0] != '#')
+            break;
+    }
+
+    if (sscanf(line.c_str(), "x = %d, y = %d", &pattern.width, &pattern.height) != 2) {
+        std::cerr << path << " doesn't look like an RLE pattern!" << std::endl;
+        return false;
+    }
+
+    pattern.cells.assign((size_t)pattern.width * pattern.height, 0);
+
+    // The body is runs of 'b' (dead), 'o' (alive) and '$' (end of row),
+    // each optionally preceded by a count, terminated by '!'
+    int row = 0, column = 0, runCount = 0;
+    char c;
+
+    while (patternFile.get(c)) {
+        if (c >= '0' && c <= '9') {
+            runCount = runCount * 10 + (c - '0');
+        }
+        else if (c == 'b' || c == 'o') {
+            int run = std::max(runCount, 1);
+
+            for (int i = 0; i < run; i++, column++) {
+                if (c == 'o' && row < pattern.height && column < pattern.width)
+                    pattern.cells[(size_t)row * pattern.width + column] = 1;
+            }
+
+            runCount = 0;
+        }
+        else if (c == '$') {
+            row += std::max(runCount, 1);
+            column = 0;
+            runCount = 0;
+        }
+        else if (c == '!') {
+            break;
+        }
+        // Anything else (whitespace, line breaks) is just skipped
+    }
+
+    return true;
+}
+
+// Stamp a pattern's live cells onto the board at the given position (x cells
+// in from the left edge, y cells down from the top, as RLE tooling usually
+// counts), then re-upload just the word-aligned box the pattern touched -
+// never the whole board
+void placePattern(const RLEPattern& pattern, int destX, int destY, uint32_t* board)
+{
+    for (int row = 0; row < pattern.height; row++) {
+        // Our board stores row zero at the bottom (the PNG loader flips), so
+        // flip the pattern's top-down rows to match
+        int boardY = gridHeight - 1 - (destY + row);
+
+        if (boardY < 0 || boardY >= gridHeight)
+            continue;
+
+        for (int column = 0; column < pattern.width; column++) {
+            if (!pattern.cells[(size_t)row * pattern.width + column])
+                continue;
+
+            int boardX = destX + column;
+            if (boardX < 0 || boardX >= gridWidth)
+                continue;
+
+            board[(size_t)boardY * wordsPerRow + (boardX / 32)] |= 1u << (boardX % 32);
+        }
+    }
+
+    // On the CPU path the engine re-reads the whole board after placement,
+    // so there's nothing to upload
+    if (useCpuEngine)
+        return;
+
+    // The word-aligned bounding box of what we just changed, clipped to the board
+    int firstWord = std::max(destX / 32, 0);
+    int lastWord = std::min((destX + pattern.width - 1) / 32, wordsPerRow - 1);
+    int firstRow = std::max(gridHeight - (destY + pattern.height), 0);
+    int lastRow = std::min(gridHeight - 1 - destY, gridHeight - 1);
+
+    if (firstWord > lastWord || firstRow > lastRow)
+        return;
+
+    glBindTexture(GL_TEXTURE_2D, gpuEngineBoardTexture());
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, wordsPerRow);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, firstWord, firstRow, lastWord - firstWord + 1, lastRow - firstRow + 1,
+        GL_RED_INTEGER, GL_UNSIGNED_INT, board + (size_t)firstRow * wordsPerRow + firstWord);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+}
+
+void runBenchmark(int generations)
+{
+    double seconds = 0;
+
+    if (useCpuEngine || numPartitions > 1) {
+        // GPU timer queries can't see CPU work, or work queued on the band
+        // contexts, so time these by the wall clock instead. The band
+        // workers' dispatches are all ordered before our own queue's tail,
+        // so a glFinish here really does cover everything
+        simulationTick(10);
+        if (numPartitions > 1)
+            glFinish();
+
+        auto startTime = std::chrono::steady_clock::now();
+        simulationTick(generations);
+        if (numPartitions > 1)
+            glFinish();
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    }
+    else if (detectMaxPeriod > 0) {
+        // With convergence detection on, run in chunks and look at the probe
+        // verdicts between them, so a board that settles early stops the
+        // clock (and the run) there instead of grinding out the rest
+        GLuint timerQuery;
+        glGenQueries(1, &timerQuery);
+
+        simulationTick(10);
+        pumpDetectionProbe(true);
+
+        GLuint64 totalNanoseconds = 0;
+        int generationsRun = 0;
+
+        while (generationsRun < generations && detectedPeriod == 0) {
+            int chunk = std::min(256, generations - generationsRun);
+
+            glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+            simulationTick(chunk);
+            glEndQuery(GL_TIME_ELAPSED);
+
+            GLuint64 elapsedNanoseconds = 0;
+            glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsedNanoseconds);
+            totalNanoseconds += elapsedNanoseconds;
+            generationsRun += chunk;
+
+            pumpDetectionProbe(true);
+        }
+
+        if (detectedPeriod == 1)
+            std::cout << "Board settled into a still life after " << generationsRun << " generations - stopping early" << std::endl;
+        else if (detectedPeriod > 1)
+            std::cout << "Board settled into a period-" << detectedPeriod << " oscillation after " << generationsRun << " generations - stopping early" << std::endl;
+
+        seconds = totalNanoseconds / 1e9;
+        generations = generationsRun;
+        glDeleteQueries(1, &timerQuery);
+    }
+    else {
+        GLuint timerQuery;
+        glGenQueries(1, &timerQuery);
+
+        // A few warmup generations first, so one-off driver work (shader
+        // specialization and the like) doesn't pollute the numbers
+        simulationTick(10);
+
+        // Time the whole batch of dispatches on the GPU itself
+        glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+        simulationTick(generations);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        // Fetching the result waits for the GPU to finish the batch
+        GLuint64 elapsedNanoseconds = 0;
+        glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsedNanoseconds);
+
+        seconds = elapsedNanoseconds / 1e9;
+        glDeleteQueries(1, &timerQuery);
+    }
 
-    // Make sure that our compute shader has finished writing to the image
-    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+    double generationsPerSecond = generations / seconds;
 
-    // Copy the output texture to be the input texture on the next frame
-    glCopyImageSubData(outputTexture, GL_TEXTURE_2D, 0, 0, 0, 0, inputTexture, GL_TEXTURE_2D, 0, 0, 0, 0, gridWidth, gridHeight, 1);
+    std::cout << "Benchmark: " << generations << " generations of a "
+        << gridWidth << " x " << gridHeight << " board" << std::endl;
+    std::cout << "  " << seconds << " seconds" << std::endl;
+    std::cout << "  " << generationsPerSecond << " generations/sec" << std::endl;
+    std::cout << "  " << generationsPerSecond * gridWidth * gridHeight << " cell-updates/sec" << std::endl;
+}
 
-    // Make sure the copy is complete
-    glMemoryBarrier(GL_ALL_BARRIER_BITS);
+// The texture array layer holding the generation rewindOffset steps behind
+// the newest stored one
+int historyLayerForOffset(int offset)
+{
+    return (int)((historyHead - 1 - offset) % historyDepth);
 }
 
 void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods)
@@ -164,47 +1498,547 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
     if (action != GLFW_PRESS && action != GLFW_REPEAT)
         return;
 
+    // Only the one-shot toggles live here. The continuous controls (pan and
+    // zoom) are polled per frame in processInput instead, so their speed
+    // doesn't depend on the OS key-repeat rate
     switch (key) {
-        case GLFW_KEY_W:
-            currentYOffset += 0.01f;
+        case GLFW_KEY_SPACE:
+            simulationIsRunning = !simulationIsRunning;
             break;
 
-        case GLFW_KEY_S:
-            currentYOffset -= 0.01f;
+        case GLFW_KEY_T:
+            // Ticking from inside a GLFW callback would land mid-frame, so
+            // just ask the main loop to do it
+            singleStepRequested = true;
             break;
 
-        case GLFW_KEY_A:
-            currentXOffset -= 0.01f;
+        case GLFW_KEY_LEFT_BRACKET:
+            // With a wall-clock target set, the brackets move that instead
+            if (targetGenerationsPerSecond > 0.0f) {
+                targetGenerationsPerSecond = std::max(targetGenerationsPerSecond / 2.0f, 1.0f);
+                std::cout << "Target generations per second: " << targetGenerationsPerSecond << std::endl;
+            }
+            else {
+                generationsPerFrame = std::max(generationsPerFrame / 2, 1);
+                std::cout << "Generations per frame: " << generationsPerFrame << std::endl;
+            }
             break;
 
-        case GLFW_KEY_D:
-            currentXOffset += 0.01f;
+        case GLFW_KEY_RIGHT_BRACKET:
+            if (targetGenerationsPerSecond > 0.0f) {
+                targetGenerationsPerSecond *= 2.0f;
+                std::cout << "Target generations per second: " << targetGenerationsPerSecond << std::endl;
+            }
+            else {
+                generationsPerFrame *= 2;
+                std::cout << "Generations per frame: " << generationsPerFrame << std::endl;
+            }
             break;
 
-        case GLFW_KEY_SPACE:
-            simulationIsRunning = !simulationIsRunning;
+        case GLFW_KEY_H:
+            // The heatmap needs the compute kernel to maintain the ages, so
+            // it's GPU-only for now - and the band workers don't track age,
+            // so partitioned runs are out too
+            if (!useCpuEngine && numPartitions == 1)
+                ageHeatmap = !ageHeatmap;
             break;
 
-        case GLFW_KEY_EQUAL:
-            currentScale += 0.1f;
+        case GLFW_KEY_LEFT:
+            // Step backwards through the history ring, pausing the run so
+            // the view stays put
+            if (historyDepth > 0 && historyHead > 0) {
+                long long available = std::min(historyHead, (long long)historyDepth);
+
+                if (rewindOffset + 1 < available) {
+                    rewindOffset++;
+                    simulationIsRunning = false;
+                    std::cout << "Viewing generation " << historyGenerations[historyLayerForOffset(rewindOffset)] << std::endl;
+                }
+            }
             break;
 
-        case GLFW_KEY_MINUS:
-            currentScale -= 0.1f;
+        case GLFW_KEY_RIGHT:
+            if (rewindOffset > 0) {
+                rewindOffset--;
+
+                if (rewindOffset == 0)
+                    std::cout << "Viewing the live board" << std::endl;
+                else
+                    std::cout << "Viewing generation " << historyGenerations[historyLayerForOffset(rewindOffset)] << std::endl;
+            }
             break;
 
-        case GLFW_KEY_T:
-            simulationTick();
+        case GLFW_KEY_F:
+            // Diff the generation on screen against the one before it
+            if (historyDepth > 0)
+                diffView = !diffView;
+            break;
+
+        case GLFW_KEY_R:
+            // ROI mode leans on the dense dispatch machinery, so it needs
+            // the single-context GPU path like the other view extras
+            if (!useCpuEngine && numPartitions == 1) {
+                roiMode = !roiMode;
+
+                if (roiMode) {
+                    roiSyncPending = true;
+                    std::cout << "Simulating only the viewport (approximate - the frozen surroundings bleed in over time) - press R again for the whole board" << std::endl;
+                }
+                else {
+                    roiWakePending = true;
+                    std::cout << "Simulating the whole board again" << std::endl;
+                }
+            }
+            break;
+
+        case GLFW_KEY_I:
+            showTimings = !showTimings;
+
+            // Put the title back to normal when the readout is switched off
+            if (!showTimings)
+                glfwSetWindowTitle(window, "GameOfLife");
             break;
     }
+}
+
+void mouse_button_callback(GLFWwindow* window, int button, int action, int mods)
+{
+    if (button == GLFW_MOUSE_BUTTON_LEFT)
+        paintingCells = action == GLFW_PRESS;
+    if (button == GLFW_MOUSE_BUTTON_RIGHT)
+        erasingCells = action == GLFW_PRESS;
+
+    // Every new stroke starts fresh - don't draw a line from the last one
+    if (action == GLFW_PRESS) {
+        lastEditCellX = -1;
+        lastEditCellY = -1;
+    }
+}
+
+// Polled once per frame: move the viewport by a velocity scaled with the
+// frame delta, so panning and zooming stay smooth however long the frame
+// took - even at silly generations-per-frame settings
+void processInput(GLFWwindow* window, float deltaTime)
+{
+    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS)
+        currentYOffset += panSpeed * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS)
+        currentYOffset -= panSpeed * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS)
+        currentXOffset -= panSpeed * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
+        currentXOffset += panSpeed * deltaTime;
+
+    if (glfwGetKey(window, GLFW_KEY_EQUAL) == GLFW_PRESS)
+        currentScale += zoomSpeed * deltaTime;
+    if (glfwGetKey(window, GLFW_KEY_MINUS) == GLFW_PRESS)
+        currentScale -= zoomSpeed * deltaTime;
 
     if (currentScale <= 0.0) {
         currentScale = 0.1f;
     }
 }
 
-int main()
+// Polled once per frame while a mouse button is held: turn the cursor
+// position into board cell coordinates (the inverse of the fragment
+// shader's viewport transform) and queue the cells up for this frame's
+// edit pass, walking a line from the last painted cell so fast drags
+// leave no gaps
+void collectPendingEdits(GLFWwindow* window)
 {
+    if (!paintingCells && !erasingCells)
+        return;
+
+    // In partitioned mode the simulation lives in the band textures, which
+    // an edit to the main board would never reach
+    if (numPartitions > 1)
+        return;
+
+    int windowWidth, windowHeight;
+    glfwGetWindowSize(window, &windowWidth, &windowHeight);
+
+    double cursorX, cursorY;
+    glfwGetCursorPos(window, &cursorX, &cursorY);
+
+    float boardX = ((float)cursorX / windowWidth) / currentScale + currentXOffset;
+    float boardY = (1.0f - (float)cursorY / windowHeight) / currentScale + currentYOffset;
+
+    // Off the board (in the border)? Then the stroke is broken too
+    if (boardX < 0.0f || boardX >= 1.0f || boardY < 0.0f || boardY >= 1.0f) {
+        lastEditCellX = -1;
+        lastEditCellY = -1;
+        return;
+    }
+
+    int cellX = std::min((int)(boardX * gridWidth), gridWidth - 1);
+    int cellY = std::min((int)(boardY * gridHeight), gridHeight - 1);
+
+    // If both buttons are down, painting wins
+    uint32_t paint = paintingCells ? 1u : 0u;
+
+    int steps = 1;
+    if (lastEditCellX >= 0) {
+        int dx = cellX > lastEditCellX ? cellX - lastEditCellX : lastEditCellX - cellX;
+        int dy = cellY > lastEditCellY ? cellY - lastEditCellY : lastEditCellY - cellY;
+        steps = std::max(std::max(dx, dy), 1);
+    }
+
+    for (int s = 1; s <= steps; s++) {
+        int x = lastEditCellX >= 0 ? lastEditCellX + (cellX - lastEditCellX) * s / steps : cellX;
+        int y = lastEditCellY >= 0 ? lastEditCellY + (cellY - lastEditCellY) * s / steps : cellY;
+
+        pendingEdits.push_back((uint32_t)x | (paint << 31));
+        pendingEdits.push_back((uint32_t)y);
+    }
+
+    lastEditCellX = cellX;
+    lastEditCellY = cellY;
+}
+
+// Apply the frame's batched edits in one go
+void applyPendingEdits()
+{
+    if (pendingEdits.empty())
+        return;
+
+    int numEdits = (int)(pendingEdits.size() / 2);
+
+    if (useCpuEngine) {
+        for (int i = 0; i < numEdits; i++) {
+            uint32_t xWord = pendingEdits[2 * i];
+            cpuEngineSetCell((int)(xWord & 0x7FFFFFFF), (int)pendingEdits[2 * i + 1], (xWord >> 31) != 0);
+        }
+
+        cpuBoardDirty = true;
+    }
+    else {
+        // Stream the list through the edit buffer and let the pass OR / AND
+        // the bits in place, waking the affected tiles for the scheduler
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, editBuffer);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, pendingEdits.size() * sizeof(uint32_t), pendingEdits.data(), GL_STREAM_DRAW);
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+        glUseProgram(editProgram);
+        glUniform1i(numEditsUniformLocation, numEdits);
+        glBindImageTexture(0, gpuEngineBoardTexture(), 0, GL_FALSE, 0, GL_READ_WRITE, GL_R32UI);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, gpuEngineActivityBuffer());
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, editBuffer);
+        glDispatchCompute((GLuint)((numEdits + 63) / 64), 1, 1);
+
+        // The next tick reads the edited cells and flags
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+        // And show the edit right away, even while paused
+        publishDisplayBoard();
+    }
+
+    pendingEdits.clear();
+}
+
+// Parse a rule in B/S notation ("B36/S23") into birth and survival masks.
+// Returns false if the text isn't a well-formed rule
+bool parseRule(const char* text, uint32_t* birth, uint32_t* survive)
+{
+    std::string rule = text;
+    size_t slash = rule.find('/');
+
+    if (slash == std::string::npos || slash + 1 >= rule.size())
+        return false;
+    if (rule[0] != 'B' && rule[0] != 'b')
+        return false;
+    if (rule[slash + 1] != 'S' && rule[slash + 1] != 's')
+        return false;
+
+    *birth = 0;
+    *survive = 0;
+
+    for (size_t i = 1; i < slash; i++) {
+        if (rule[i] < '0' || rule[i] > '8')
+            return false;
+        *birth |= 1u << (rule[i] - '0');
+    }
+
+    for (size_t i = slash + 2; i < rule.size(); i++) {
+        if (rule[i] < '0' || rule[i] > '8')
+            return false;
+        *survive |= 1u << (rule[i] - '0');
+    }
+
+    return true;
+}
+
+// The same PCG hash as generate.comp, so boards generated on the CPU
+// fallback come out identical to GPU-generated ones for the same seed
+uint32_t pcgHash(uint32_t value)
+{
+    value = value * 747796405u + 2891336453u;
+    uint32_t word = ((value >> ((value >> 28u) + 4u)) ^ value) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Generate the random board in client memory - the CPU path's stand-in for
+// generate.comp, bit-for-bit compatible with it
+void generateBoardOnCpu(uint32_t* packedBoard)
+{
+    uint32_t aliveThreshold = randomDensity >= 1.0f ? 0xFFFFFFFFu : (uint32_t)(randomDensity * 4294967296.0);
+
+    for (int y = 0; y < gridHeight; y++) {
+        for (int x = 0; x < gridWidth; x++) {
+            uint32_t cellIndex = (uint32_t)y * (uint32_t)gridWidth + (uint32_t)x;
+
+            if (pcgHash(randomSeed ^ pcgHash(cellIndex)) < aliveThreshold)
+                packedBoard[y * wordsPerRow + (x / 32)] |= 1u << (x % 32);
+        }
+    }
+}
+
+// Restore a crashed run (--resume): adopt the checkpoint's dimensions and
+// bring the generation counter, tick batch size and viewport back from the
+// sidecar. The board itself gets memory-mapped later, through the same path
+// as a .board setup file. Returns false if either file is missing or bad
+bool loadRunState()
+{
+    // The board's own header carries the dimensions, so --width / --height
+    // don't have to be repeated (or remembered) three days later
+    std::ifstream boardFile(CHECKPOINT_PATH, std::ios::binary);
+    uint32_t boardHeader[3] = { 0, 0, 0 };
+
+    if (boardFile)
+        boardFile.read((char*)boardHeader, sizeof(boardHeader));
+
+    if (!boardFile || boardHeader[0] != BOARD_FILE_MAGIC) {
+        std::cerr << "No usable " << CHECKPOINT_PATH << " to resume from!" << std::endl;
+        return false;
+    }
+
+    uint32_t stateWords[7] = { 0 };
+    std::ifstream stateFile(RUN_STATE_PATH, std::ios::binary);
+
+    if (stateFile)
+        stateFile.read((char*)stateWords, sizeof(stateWords));
+
+    if (!stateFile || stateWords[0] != RUN_STATE_MAGIC) {
+        std::cerr << "No usable " << RUN_STATE_PATH << " to resume from!" << std::endl;
+        return false;
+    }
+
+    gridWidth = (int)boardHeader[1];
+    gridHeight = (int)boardHeader[2];
+
+    generationCount = (long long)stateWords[1] | ((long long)stateWords[2] << 32);
+    generationsPerFrame = std::max((int)stateWords[3], 1);
+    std::memcpy(&currentScale, &stateWords[4], sizeof(float));
+    std::memcpy(&currentXOffset, &stateWords[5], sizeof(float));
+    std::memcpy(&currentYOffset, &stateWords[6], sizeof(float));
+
+    // Don't write the next checkpoint until a full interval past this one
+    lastCheckpointGeneration = generationCount;
+
+    std::cout << "Resuming a " << gridWidth << " x " << gridHeight << " board from generation " << generationCount << std::endl;
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    // Patterns to stamp onto the board at startup (--place)
+    struct PatternPlacement {
+        const char* path;
+        int x, y;
+    };
+    std::vector<PatternPlacement> placements;
+
+    // Parse our command line options
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+
+        if (arg == "--benchmark" && i + 1 < argc) {
+            benchmarkGenerations = std::atoi(argv[++i]);
+        }
+        else if (arg == "--width" && i + 1 < argc) {
+            gridWidth = std::atoi(argv[++i]);
+        }
+        else if (arg == "--height" && i + 1 < argc) {
+            gridHeight = std::atoi(argv[++i]);
+        }
+        else if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        }
+        else if (arg == "--checkpoint" && i + 1 < argc) {
+            checkpointInterval = std::atoi(argv[++i]);
+        }
+        else if (arg == "--sparse") {
+            sparseMode = true;
+        }
+        else if (arg == "--cpu") {
+            useCpuEngine = true;
+        }
+        else if (arg == "--partitions" && i + 1 < argc) {
+            numPartitions = std::atoi(argv[++i]);
+        }
+        else if (arg == "--fastforward" && i + 1 < argc) {
+            fastForwardGenerations = std::atoll(argv[++i]);
+        }
+        else if (arg == "--census" && i + 1 < argc) {
+            censusPath = argv[++i];
+        }
+        else if (arg == "--record" && i + 2 < argc) {
+            recordPath = argv[i + 1];
+            recordInterval = std::atoi(argv[i + 2]);
+            i += 2;
+        }
+        else if (arg == "--seed" && i + 1 < argc) {
+            randomizeBoard = true;
+            randomSeed = (uint32_t)std::strtoul(argv[++i], NULL, 10);
+        }
+        else if (arg == "--density" && i + 1 < argc) {
+            randomDensity = (float)std::atof(argv[++i]);
+        }
+        else if (arg == "--resume") {
+            resumeRun = true;
+        }
+        else if (arg == "--history" && i + 1 < argc) {
+            historyDepth = std::atoi(argv[++i]);
+        }
+        else if (arg == "--detect" && i + 1 < argc) {
+            detectMaxPeriod = std::atoi(argv[++i]);
+        }
+        else if (arg == "--gps" && i + 1 < argc) {
+            targetGenerationsPerSecond = (float)std::atof(argv[++i]);
+        }
+        else if (arg == "--uncapped") {
+            uncappedFrameRate = true;
+        }
+        else if (arg == "--rule" && i + 1 < argc) {
+            if (!parseRule(argv[++i], &birthMask, &surviveMask)) {
+                std::cerr << "Couldn't parse rule " << argv[i] << " - expected B/S notation, like B36/S23" << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--boundary" && i + 1 < argc) {
+            std::string mode = argv[++i];
+
+            if (mode == "dead")
+                boundaryMode = 0;
+            else if (mode == "wrap")
+                boundaryMode = 1;
+            else if (mode == "reflect")
+                boundaryMode = 2;
+            else {
+                std::cerr << "Unknown boundary mode: " << mode << std::endl;
+                return 1;
+            }
+        }
+        else if (arg == "--place" && i + 3 < argc) {
+            PatternPlacement placement = { argv[i + 1], std::atoi(argv[i + 2]), std::atoi(argv[i + 3]) };
+            placements.push_back(placement);
+            i += 3;
+        }
+        else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            return 1;
+        }
+    }
+
+    // A resumed run takes its board (and its dimensions) from the last
+    // checkpoint, so a generated starting board makes no sense alongside it
+    if (resumeRun && randomizeBoard) {
+        std::cerr << "--resume and --seed can't be combined!" << std::endl;
+        return 1;
+    }
+
+    if (resumeRun && !loadRunState())
+        return 1;
+
+    if (gridWidth <= 0 || gridHeight <= 0) {
+        std::cerr << "Grid dimensions must be positive!" << std::endl;
+        return 1;
+    }
+
+    if (randomDensity < 0.0f || randomDensity > 1.0f) {
+        std::cerr << "The density must be between 0 and 1!" << std::endl;
+        return 1;
+    }
+
+    // A B0 rule flickers the empty background every generation, which breaks
+    // the dead padding bits, the dead boundary and the sparse scheduler's
+    // "unchanged tiles stay unchanged" assumption all at once
+    if (birthMask & 1u) {
+        std::cerr << "B0 rules aren't supported!" << std::endl;
+        return 1;
+    }
+
+    // The CPU engine and HashLife have B3/S23 baked into their arithmetic
+    bool standardRule = birthMask == (1u << 3) && surviveMask == ((1u << 2) | (1u << 3));
+
+    if (!standardRule && (useCpuEngine || fastForwardGenerations > 0)) {
+        std::cerr << "The CPU engine and fast-forward only play standard Life (B3/S23)!" << std::endl;
+        return 1;
+    }
+
+    // The wrapping boundary modes work on whole 32-cell words, so they only
+    // make sense when the rows have no padding bits
+    if (boundaryMode != 0 && gridWidth % 32 != 0) {
+        std::cerr << "The wrap and reflect boundary modes need the board width to be a multiple of 32!" << std::endl;
+        return 1;
+    }
+
+    if (boundaryMode != 0 && useCpuEngine) {
+        std::cerr << "The CPU engine only supports dead boundaries - carrying on with those" << std::endl;
+        boundaryMode = 0;
+    }
+
+    if (numPartitions < 1)
+        numPartitions = 1;
+
+    if (numPartitions > 1) {
+        // Each band needs at least one real row, and a band's halo has to
+        // come from an immediate neighbour - wrapping boundaries would need
+        // the top and bottom bands talking to each other too
+        if (numPartitions > gridHeight) {
+            std::cerr << "Can't split " << gridHeight << " rows into " << numPartitions << " bands!" << std::endl;
+            return 1;
+        }
+
+        if (boundaryMode != 0) {
+            std::cerr << "Partitioned simulation only supports dead boundaries!" << std::endl;
+            return 1;
+        }
+
+        if (useCpuEngine) {
+            std::cerr << "The CPU engine doesn't partition - carrying on with one band" << std::endl;
+            numPartitions = 1;
+        }
+
+        if (sparseMode) {
+            std::cerr << "Sparse scheduling isn't partition-aware yet - carrying on dense" << std::endl;
+            sparseMode = false;
+        }
+    }
+
+    if (censusPath != NULL && (useCpuEngine || numPartitions > 1)) {
+        std::cerr << "The census needs the single-context GPU path - carrying on without it" << std::endl;
+        censusPath = NULL;
+    }
+
+    if (historyDepth > 0 && (useCpuEngine || numPartitions > 1)) {
+        std::cerr << "The history ring needs the single-context GPU path - carrying on without it" << std::endl;
+        historyDepth = 0;
+    }
+
+    if (detectMaxPeriod > 0 && (useCpuEngine || numPartitions > 1)) {
+        std::cerr << "Convergence detection needs the single-context GPU path - carrying on without it" << std::endl;
+        detectMaxPeriod = 0;
+    }
+
+    // The probes compare against the history ring, so it has to reach back
+    // far enough - the ring's newest layer duplicates the live board, hence
+    // the extra one
+    if (detectMaxPeriod > 0 && historyDepth < detectMaxPeriod + 1)
+        historyDepth = detectMaxPeriod + 1;
+
+    // Now that we know the board width, we know how many words each row packs into
+    wordsPerRow = (gridWidth + 31) / 32;
+
     // Initalize GLFW and GLAD
     glfwSetErrorCallback(errorCallback);
 
@@ -213,33 +2047,83 @@ int main()
         return -1;
     }
 
-    // Specify a minimum version of OpenGL our application can use
-    // Because we use glCopyImageSubData, we'll need at least OpenGL 4.3
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    // In benchmark mode we still need a window for its GL context, but we
+    // never show it
+    if (benchmarkGenerations > 0)
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
     // Window creation
-    GLFWwindow* window = glfwCreateWindow(width, height, "GameOfLife", NULL, NULL);
+    // Because we use compute shaders, we'll ask for at least OpenGL 4.3 - and
+    // if the driver can't manage that (or --cpu was passed), fall back to the
+    // CPU engine, which only needs 3.3 to draw
+    GLFWwindow* window = NULL;
+
+    if (!useCpuEngine) {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(width, height, "GameOfLife", NULL, NULL);
+    }
+
+    if (window == NULL) {
+        if (!useCpuEngine)
+            std::cerr << "No OpenGL 4.3 context available - falling back to the CPU engine" << std::endl;
+
+        if (!standardRule) {
+            std::cerr << "The CPU engine only plays standard Life (B3/S23)!" << std::endl;
+            glfwTerminate();
+            return 1;
+        }
+
+        useCpuEngine = true;
+        numPartitions = 1;
+        censusPath = NULL;
+        historyDepth = 0;
+        detectMaxPeriod = 0;
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(width, height, "GameOfLife", NULL, NULL);
+
+        if (window == NULL) {
+            std::cerr << "Failed to create a window!" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+    }
 
     glfwMakeContextCurrent(window);
     gladLoadGL(glfwGetProcAddress);
-    glfwSwapInterval(1); // enable vsync
-
-    // Compile all of our shaders
-    GLuint quadVertexShader = loadCompileShader("quad.vert", GL_VERTEX_SHADER);
-    GLuint quadFragmentShader = loadCompileShader("quad.frag", GL_FRAGMENT_SHADER);
-    GLuint computeShader = loadCompileShader("gameoflife.comp", GL_COMPUTE_SHADER);
-
-    // Link the render & compute pipelines together into programs
-    GLuint renderShaders[] = { quadVertexShader, quadFragmentShader };
-    GLuint renderProgram = createLinkProgram(renderShaders, 2);
-    computeProgram = createLinkProgram(&computeShader, 1);
-
-    // Cleanup the shaders - now that we have our programs, we don't need
-    // them anymore
-    glDeleteShader(quadVertexShader);
-    glDeleteShader(quadFragmentShader);
-    glDeleteShader(computeShader);
+    glfwSwapInterval(uncappedFrameRate ? 0 : 1); // vsync, unless --uncapped
+
+    // Build all of our programs, by way of the on-disk binary cache - on a
+    // warm start none of this actually compiles anything
+    const char* renderPaths[] = { "quad.vert", "quad.frag" };
+    const GLenum renderTypes[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+    GLuint renderProgram = loadProgramCached(renderPaths, renderTypes, 2);
+
+    // The compute pipeline only exists on the GPU path. The engine builds
+    // the kernel and the scheduler (autotuning the kernel's workgroup shape
+    // along the way); the app's own helper passes load here
+    if (!useCpuEngine) {
+        const char* populationPath = "population.comp";
+        const char* downsamplePath = "downsample.comp";
+        const char* generatePath = "generate.comp";
+        const char* editPath = "edit.comp";
+        const char* comparePath = "compare.comp";
+        const GLenum computeType = GL_COMPUTE_SHADER;
+
+        gpuEngineInit(gridWidth, gridHeight, birthMask, surviveMask, boundaryMode, 0);
+
+        // The edit pass gets the kernel's workgroup size spliced in, so its
+        // tile-waking arithmetic agrees with the kernel's
+        char sizePrelude[48];
+        snprintf(sizePrelude, sizeof(sizePrelude), "#define WORKGROUP_SIZE %d\n", gpuEngineWorkgroupSize());
+
+        populationProgram = loadProgramCached(&populationPath, &computeType, 1);
+        downsampleProgram = loadProgramCached(&downsamplePath, &computeType, 1);
+        generateProgram = loadProgramCached(&generatePath, &computeType, 1);
+        editProgram = loadProgramCached(&editPath, &computeType, 1, sizePrelude);
+        compareProgram = loadProgramCached(&comparePath, &computeType, 1);
+    }
 
     // Grab the references to uniforms for our render program
     GLint scaleUniformLocation = glGetUniformLocation(renderProgram, "scale");
@@ -262,78 +2146,530 @@ int main()
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
 
-    // Load in our inital setup
-    int imgWidth, imgHeight, numChannels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(INITAL_SETUP_PATH, &imgWidth, &imgHeight, &numChannels, 0);
+    // Load in our inital setup. A packed .board file is already in exactly
+    // the layout the texture wants, so it can be memory-mapped and uploaded
+    // as-is; otherwise we fall back to decoding the PNG
+    uint32_t* packedBoard = NULL;
+    bool boardWasMapped = false;
 
-    if (data == NULL) {
-        std::cerr << "Could not read the inital setup!" << std::endl;
-        return 1;
+    if (randomizeBoard) {
+        // The generator pass fills the real cells in once the textures
+        // exist; until then the board is all dead
+        packedBoard = new uint32_t[(size_t)wordsPerRow * gridHeight]();
+    }
+    else {
+        packedBoard = mapBoardFile(resumeRun ? CHECKPOINT_PATH : BOARD_SETUP_PATH);
+        boardWasMapped = packedBoard != NULL;
     }
 
-    if (imgWidth != gridWidth || imgHeight != gridHeight || numChannels != 3) {
-        std::cerr << "Inital setup image has the wrong dimensions!" << std::endl;
-        fprintf(stderr, "Expected %d x %d x 3, got %d x %d x %d", gridWidth, gridHeight, imgWidth, imgHeight, numChannels);
+    // Resuming from a checkpoint that won't map is an error, not a cue to
+    // quietly start the run over from the setup image
+    if (resumeRun && packedBoard == NULL) {
+        std::cerr << "Couldn't map " << CHECKPOINT_PATH << " to resume from!" << std::endl;
         return 1;
     }
 
-    // Create a texture for our compute shader input from / output to to
-    glGenTextures(1, &inputTexture);
-    glGenTextures(1, &outputTexture);
+    if (packedBoard == NULL) {
+        int imgWidth, imgHeight, numChannels;
+        stbi_set_flip_vertically_on_load(true);
+        unsigned char* data = stbi_load(INITAL_SETUP_PATH, &imgWidth, &imgHeight, &numChannels, 0);
+
+        if (data == NULL) {
+            std::cerr << "Could not read the inital setup!" << std::endl;
+            return 1;
+        }
+
+        if (imgWidth != gridWidth || imgHeight != gridHeight || numChannels != 3) {
+            std::cerr << "Inital setup image has the wrong dimensions!" << std::endl;
+            fprintf(stderr, "Expected %d x %d x 3, got %d x %d x %d", gridWidth, gridHeight, imgWidth, imgHeight, numChannels);
+            return 1;
+        }
+
+        // Bit-pack the image into one bit per cell - bit i of each 32-bit word
+        // holds the state of cell (wordX * 32 + i, y). Any padding bits past the
+        // board width in the last word of a row stay dead
+        packedBoard = new uint32_t[wordsPerRow * gridHeight]();
+
+        for (int y = 0; y < gridHeight; y++) {
+            for (int x = 0; x < gridWidth; x++) {
+                if (data[(y * gridWidth + x) * 3] > 127) {
+                    packedBoard[y * wordsPerRow + (x / 32)] |= 1u << (x % 32);
+                }
+            }
+        }
+
+        // We don't need our original image anymore; free it
+        stbi_image_free(data);
+    }
 
-    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    // Pattern placement merges into the board, and a mapped file is
+    // read-only - so take a mutable copy if we'll be stamping anything
+    if (!placements.empty() && boardWasMapped) {
+        uint32_t* mutableBoard = new uint32_t[(size_t)wordsPerRow * gridHeight];
+        std::copy(packedBoard, packedBoard + (size_t)wordsPerRow * gridHeight, mutableBoard);
+        unmapBoardFile();
 
-    // Create & bind the texture
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, inputTexture);
-    
-    // Set a border colour, for lookups that extend out of the usual 0-1 UV space
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+        packedBoard = mutableBoard;
+        boardWasMapped = false;
+    }
 
-    // Interpolation mode. We're essentially rendering pixel art, so we use GL_NEAREST
-    // (essentially, no fancy interpolation whatsoever)
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    // Seed the engine's board with the packed inital state. The engine made
+    // its ping-pong textures (and the age texture) during gpuEngineInit
+    if (!useCpuEngine)
+        gpuEngineUpload(packedBoard);
+
+    // Generated boards get their cells from the GPU - and read straight
+    // back, so everything that works from the packed board (pattern stamps,
+    // the bands, fast-forward, the CPU engine) sees the same cells. The CPU
+    // fallback runs the identical hash in client memory instead
+    if (randomizeBoard) {
+        if (!useCpuEngine) {
+            uint32_t aliveThreshold = randomDensity >= 1.0f ? 0xFFFFFFFFu : (uint32_t)(randomDensity * 4294967296.0);
+
+            glUseProgram(generateProgram);
+            glUniform1ui(glGetUniformLocation(generateProgram, "randomSeed"), randomSeed);
+            glUniform1ui(glGetUniformLocation(generateProgram, "aliveThreshold"), aliveThreshold);
+            glUniform1i(glGetUniformLocation(generateProgram, "gridWidthCells"), gridWidth);
+
+            glBindImageTexture(0, gpuEngineBoardTexture(), 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+            glDispatchCompute((GLuint)(wordsPerRow + workgroupSize - 1) / workgroupSize, (GLuint)(gridHeight + workgroupSize - 1) / workgroupSize, 1);
+
+            // One synchronous readback, once, at startup - that's fine
+            gpuEngineReadback(packedBoard);
+        }
+        else {
+            generateBoardOnCpu(packedBoard);
+        }
+    }
+
+    if (!useCpuEngine) {
+        // The coarse overview texture: one byte per 32x32 block of cells
+        coarseHeight = (gridHeight + 31) / 32;
+
+        glGenTextures(1, &coarseTexture);
+        glBindTexture(GL_TEXTURE_2D, coarseTexture);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, wordsPerRow, coarseHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, NULL);
+
+        // The history ring: one bit-packed layer per stored generation. At
+        // 4 bytes per 32 cells, even tens of layers of a big board stay
+        // comfortably resident
+        if (historyDepth > 0) {
+            glGenTextures(1, &historyTexture);
+            glBindTexture(GL_TEXTURE_2D_ARRAY, historyTexture);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R32UI, wordsPerRow, gridHeight, historyDepth, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+
+            historyGenerations.assign(historyDepth, 0);
+        }
+
+        // The convergence probe's flag buffer and its staging twin, one
+        // word per candidate period
+        if (detectMaxPeriod > 0) {
+            glGenBuffers(1, &detectionBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, detectionBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, (size_t)detectMaxPeriod * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+            glGenBuffers(1, &detectionReadbackBuffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, detectionReadbackBuffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, (size_t)detectMaxPeriod * sizeof(uint32_t), NULL, GL_STREAM_READ);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+            flagSlotUniformLocation = glGetUniformLocation(compareProgram, "flagSlot");
+        }
+    }
+
+    // Stamp any command-line patterns over the inital board. Each stamp only
+    // re-uploads the words inside its own bounding box
+    for (const PatternPlacement& placement : placements) {
+        RLEPattern pattern;
 
-    // Copy our inital state image into this texture
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, gridWidth, gridHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, data);
-    
-    // And finally, bind this texture into image texture slot zero
-    // so we can access it from the compute shader
-    // A note: image texture slots are distinct from texture slots
-    glBindImageTexture(0, inputTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
-
-    // We don't need our original image anymore; free it
-    stbi_image_free(data);
-
-    // Do it all again for the output texture!
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, outputTexture);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    glTexParameterfv(GL_TEXTURE_2D, GL_TEXTURE_BORDER_COLOR, borderColor);
+        if (loadRLEPattern(placement.path, pattern))
+            placePattern(pattern, placement.x, placement.y, packedBoard);
+    }
+
+    // Fast-forward: jump straight to the target generation with the
+    // HashLife engine, then push the result back into the display texture.
+    // Everything downstream - the bands, the CPU engine, checkpoints -
+    // picks up the advanced board from here
+    if (fastForwardGenerations > 0) {
+        // The engine rewrites the board in place, and a mapped file is
+        // read-only - so take a mutable copy if we're still on one
+        if (boardWasMapped) {
+            uint32_t* mutableBoard = new uint32_t[(size_t)wordsPerRow * gridHeight];
+            std::copy(packedBoard, packedBoard + (size_t)wordsPerRow * gridHeight, mutableBoard);
+            unmapBoardFile();
+
+            packedBoard = mutableBoard;
+            boardWasMapped = false;
+        }
+
+        std::cout << "Fast-forwarding " << fastForwardGenerations << " generations..." << std::endl;
+
+        auto startTime = std::chrono::steady_clock::now();
+        hashlifeAdvance(packedBoard, gridWidth, gridHeight, wordsPerRow, fastForwardGenerations);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        std::cout << "  done in " << seconds << " seconds" << std::endl;
+
+        // Advance the counter rather than set it, so this stacks with the
+        // generation a resumed run came back at
+        generationCount += fastForwardGenerations;
+        lastCheckpointGeneration = generationCount;
+
+        if (!useCpuEngine)
+            gpuEngineUpload(packedBoard);
+    }
+
+    // Partitioned mode: carve the board into bands, each with its own pair
+    // of ping-pong textures (the band's rows plus a one-row halo above and
+    // below) and its own hidden context sharing objects with ours. The
+    // workers themselves only start once everything they touch exists
+    if (numPartitions > 1) {
+        partitions.resize(numPartitions);
+
+        // Contexts have to be created on the main thread; the workers just
+        // make them current
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+        int rowsPerBand = gridHeight / numPartitions;
+
+        for (int p = 0; p < numPartitions; p++) {
+            Partition& partition = partitions[p];
+            partition.firstRow = p * rowsPerBand;
+            partition.numRows = (p == numPartitions - 1) ? gridHeight - partition.firstRow : rowsPerBand;
+            partition.fence = NULL;
+            partition.window = glfwCreateWindow(1, 1, "GameOfLife band", NULL, window);
+
+            if (partition.window == NULL) {
+                std::cerr << "Could not create a context for band " << p << "!" << std::endl;
+                return 1;
+            }
+
+            // Seed the band with its rows plus whichever halo rows actually
+            // exist on the board - the outermost halos stay dead
+            std::vector<uint32_t> band((size_t)wordsPerRow * (partition.numRows + 2), 0);
+
+            int copyFrom = std::max(partition.firstRow - 1, 0);
+            int copyTo = std::min(partition.firstRow + partition.numRows + 1, gridHeight);
+            std::copy(packedBoard + (size_t)copyFrom * wordsPerRow,
+                      packedBoard + (size_t)copyTo * wordsPerRow,
+                      band.data() + (size_t)(copyFrom - (partition.firstRow - 1)) * wordsPerRow);
+
+            glGenTextures(2, partition.textures);
+
+            for (int i = 0; i < 2; i++) {
+                glBindTexture(GL_TEXTURE_2D, partition.textures[i]);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, wordsPerRow, partition.numRows + 2, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, i == 0 ? band.data() : NULL);
+            }
+        }
+    }
+
+    // The renderer's private copy of the board, seeded with the starting
+    // state so the very first frame has something to draw. On the CPU path
+    // this doubles as the upload target for the engine's board
+    glGenTextures(1, &displayBoardTexture);
+    glBindTexture(GL_TEXTURE_2D, displayBoardTexture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, wordsPerRow, gridHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, packedBoard);
+
+    // On the CPU path, the engine needs its own copy of the board too
+    if (useCpuEngine)
+        cpuEngineInit(gridWidth, gridHeight, packedBoard, wordsPerRow);
+
+    // The textures (and engine) have their own copies now; we're done with ours
+    if (boardWasMapped)
+        unmapBoardFile();
+    else
+        delete[] packedBoard;
+
+    if (!useCpuEngine) {
+        // The interactive edit pass streams its edit list through here
+        glGenBuffers(1, &editBuffer);
+        numEditsUniformLocation = glGetUniformLocation(editProgram, "numEdits");
+
+        // The census ring, its staging buffers, and the CSV they feed
+        if (censusPath != NULL) {
+            glGenBuffers(1, &censusBuffer);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, censusBuffer);
+            glBufferData(GL_SHADER_STORAGE_BUFFER, NUM_CENSUS_SLOTS * sizeof(uint32_t), NULL, GL_DYNAMIC_COPY);
+            glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+            glGenBuffers(NUM_CENSUS_READBACKS, censusReadbackBuffers);
+            for (int i = 0; i < NUM_CENSUS_READBACKS; i++) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, censusReadbackBuffers[i]);
+                glBufferData(GL_COPY_WRITE_BUFFER, NUM_CENSUS_SLOTS * sizeof(uint32_t), NULL, GL_STREAM_READ);
+            }
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+            glUseProgram(populationProgram);
+            censusSlotUniformLocation = glGetUniformLocation(populationProgram, "censusSlot");
+
+            censusFile.open(censusPath);
+            censusFile << "generation,population" << std::endl;
+        }
+
+        // Everything the band workers share - programs, uniforms, textures -
+        // now exists, so they can start. The fence (and flush) makes it all
+        // visible on their contexts before their first dispatch
+        if (numPartitions > 1) {
+            partitionExchangeFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            glFlush();
+
+            for (int p = 0; p < numPartitions; p++)
+                partitions[p].thread = std::thread(partitionWorkerMain, p);
+        }
+    }
+
+    // The fragment shader needs the board dimensions to find the right bit
+    // for each cell, and to know which texture slot holds the ages
+    glUseProgram(renderProgram);
+    glUniform2i(glGetUniformLocation(renderProgram, "gridSize"), gridWidth, gridHeight);
+    glUniform1i(glGetUniformLocation(renderProgram, "ageTexture"), 1);
+    glUniform1i(glGetUniformLocation(renderProgram, "coarseTexture"), 2);
+    glUniform1i(glGetUniformLocation(renderProgram, "historyTexture"), 3);
+    GLint displayModeUniformLocation = glGetUniformLocation(renderProgram, "displayMode");
+    useCoarseUniformLocation = glGetUniformLocation(renderProgram, "useCoarse");
+    historyLayerUniformLocation = glGetUniformLocation(renderProgram, "historyLayer");
+    diffLayerUniformLocation = glGetUniformLocation(renderProgram, "diffLayer");
+
+    // Set up the checkpoint machinery: the pixel-pack buffer ring for
+    // asynchronous readbacks (GPU path only - the CPU engine's board is
+    // already in client memory), and the thread that writes snapshots to disk
+    if (checkpointInterval > 0) {
+        if (!useCpuEngine) {
+            glGenBuffers(NUM_CHECKPOINT_PBOS, checkpointPBOs);
+
+            for (int i = 0; i < NUM_CHECKPOINT_PBOS; i++) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, checkpointPBOs[i]);
+                glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)wordsPerRow * gridHeight * sizeof(uint32_t), NULL, GL_STREAM_READ);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+
+        checkpointWriterThread = std::thread(checkpointWriterMain);
+    }
+
+    // Same again for the recorder: its own pack-buffer ring and writer
+    if (recordPath != NULL && recordInterval > 0) {
+        if (!useCpuEngine) {
+            glGenBuffers(NUM_RECORD_PBOS, recordPBOs);
+
+            for (int i = 0; i < NUM_RECORD_PBOS; i++) {
+                glBindBuffer(GL_PIXEL_PACK_BUFFER, recordPBOs[i]);
+                glBufferData(GL_PIXEL_PACK_BUFFER, (size_t)wordsPerRow * gridHeight * sizeof(uint32_t), NULL, GL_STREAM_READ);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
 
-    // Leave this texture blank to begin with
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, gridWidth, gridHeight, 0, GL_RGBA, GL_FLOAT, NULL);
-    glBindImageTexture(1, outputTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_RGBA32F);
+        recordWriterThread = std::thread(recordWriterMain);
+    }
+
+    // In benchmark mode there's no interaction or rendering - just run the
+    // requested generations, report, and quit
+    if (benchmarkGenerations > 0) {
+        runBenchmark(benchmarkGenerations);
+
+        if (censusFile.is_open())
+            pumpCensusReadbacks(true);
+
+        if (numPartitions > 1)
+            shutdownPartitions();
+
+        // The checkpoint writer was started above and never sees the
+        // interactive shutdown below, so stop it here - returning with its
+        // handle still joinable would terminate the process and eat the
+        // exit status
+        if (checkpointWriterThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(checkpointQueueMutex);
+                checkpointWriterShouldExit = true;
+            }
+            checkpointQueueCondition.notify_one();
+            checkpointWriterThread.join();
+        }
+
+        // And the recorder's writer, which has the same problem
+        if (recordWriterThread.joinable()) {
+            {
+                std::lock_guard<std::mutex> lock(recordQueueMutex);
+                recordWriterShouldExit = true;
+            }
+            recordQueueCondition.notify_one();
+            recordWriterThread.join();
+        }
+
+        glfwDestroyWindow(window);
+        glfwTerminate();
+
+        // Sweep scripts watch the exit status: 2 means the board settled
+        // (--detect) and the remaining generations weren't worth simulating
+        return detectedPeriod > 0 ? 2 : 0;
+    }
 
     // Called whenever a key is pressed
     glfwSetKeyCallback(window, (GLFWkeyfun)key_callback);
+    glfwSetMouseButtonCallback(window, mouse_button_callback);
+
+    // Timer queries around the compute and render passes, double-buffered so
+    // each frame reads the previous frame's results instead of stalling on
+    // its own
+    GLuint computeQueries[2], renderQueries[2];
+    glGenQueries(2, computeQueries);
+    glGenQueries(2, renderQueries);
+
+    // Whether a compute query was actually issued that frame - there's
+    // nothing to time while the simulation is paused
+    bool computeQueryIssued[2] = { false, false };
+
+    std::ofstream csvFile;
+    if (csvPath != NULL) {
+        csvFile.open(csvPath);
+        csvFile << "frame,computeMs,renderMs" << std::endl;
+    }
 
-    while (!glfwWindowShouldClose(window)) {
-        if (simulationIsRunning)
-            simulationTick();
+    long frameNumber = 0;
+    double lastFrameTime = glfwGetTime();
 
-        // Render our output texture to the screen
+    while (!glfwWindowShouldClose(window)) {
+        int queryFrame = frameNumber % 2;
+        computeQueryIssued[queryFrame] = false;
+
+        // Continuous controls are polled with the frame delta, so panning
+        // speed comes out the same however long the last frame took
+        double frameTime = glfwGetTime();
+        float deltaTime = (float)(frameTime - lastFrameTime);
+        processInput(window, deltaTime);
+        lastFrameTime = frameTime;
+
+        // Gather this frame's mouse edits and apply them in one batch,
+        // before the render so they're visible immediately
+        collectPendingEdits(window);
+        applyPendingEdits();
+
+        if (checkpointInterval > 0) {
+            // Kick off a new snapshot when one is due, and hand any finished
+            // readbacks over to the writer thread
+            if (generationCount - lastCheckpointGeneration >= checkpointInterval) {
+                if (useCpuEngine) {
+                    // No GPU readback involved - snapshot straight off the
+                    // engine's board and queue it for the writer
+                    CheckpointJob job;
+                    job.board.resize(3 + (size_t)wordsPerRow * gridHeight);
+                    job.board[0] = BOARD_FILE_MAGIC;
+                    job.board[1] = (uint32_t)gridWidth;
+                    job.board[2] = (uint32_t)gridHeight;
+                    cpuEngineCopyBoard(job.board.data() + 3);
+                    job.state = captureRunState();
+
+                    {
+                        std::lock_guard<std::mutex> lock(checkpointQueueMutex);
+                        checkpointQueue.push_back(std::move(job));
+                    }
+                    checkpointQueueCondition.notify_one();
+                }
+                else {
+                    startCheckpointReadback();
+                }
+
+                lastCheckpointGeneration = generationCount;
+            }
+
+            if (!useCpuEngine)
+                pumpCheckpointReadbacks();
+        }
+
+        // Stream out any census batches the GPU has finished with
+        if (censusFile.is_open())
+            pumpCensusReadbacks(false);
+
+        // Any verdict back from the convergence probe? A settled board gets
+        // announced and paused once - resuming lets the oscillation play,
+        // and an edit that breaks the cycle re-arms the announcement
+        if (detectMaxPeriod > 0) {
+            pumpDetectionProbe(false);
+
+            if (detectedPeriod > 0 && !convergenceAnnounced) {
+                if (detectedPeriod == 1)
+                    std::cout << "Board settled into a still life at generation " << detectionGeneration << " - pausing" << std::endl;
+                else
+                    std::cout << "Board settled into a period-" << detectedPeriod << " oscillation at generation " << detectionGeneration << " - pausing" << std::endl;
+
+                simulationIsRunning = false;
+                convergenceAnnounced = true;
+            }
+            else if (detectedPeriod == 0) {
+                convergenceAnnounced = false;
+            }
+        }
+
+        if (recordInterval > 0 && recordPath != NULL) {
+            // Capture a frame when one is due, and retire finished readbacks
+            if (generationCount - lastRecordedGeneration >= recordInterval) {
+                if (useCpuEngine) {
+                    // The board is already in client memory - package the
+                    // frame up directly and queue it for the writer
+                    std::vector<uint32_t> frame(2 + (size_t)wordsPerRow * gridHeight);
+                    frame[0] = (uint32_t)(generationCount & 0xFFFFFFFF);
+                    frame[1] = (uint32_t)(generationCount >> 32);
+                    cpuEngineCopyBoard(frame.data() + 2);
+
+                    {
+                        std::lock_guard<std::mutex> lock(recordQueueMutex);
+                        recordQueue.push_back(std::move(frame));
+                    }
+                    recordQueueCondition.notify_one();
+                }
+                else {
+                    startRecordReadback();
+                }
+
+                lastRecordedGeneration = generationCount;
+            }
+
+            if (!useCpuEngine)
+                pumpRecordReadbacks();
+        }
+
+        // Render first, then simulate: the draw only needs the generation
+        // published at the end of last frame's tick, so issuing it ahead of
+        // this frame's dispatches lets the GPU rasterize it while the new
+        // generations compute, instead of the two queueing up behind each
+        // other. At display rates the one-frame lag is invisible
         int windowWidth, windowHeight;
         glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
         glViewport(0, 0, windowWidth, windowHeight);
 
+        // Zoomed out far enough that every pixel covers a whole 32x32
+        // block? Then render from the coarse overview instead, rebuilding
+        // it first if the board has moved on since it was last built
+        bool useCoarse = false;
+
+        if (!useCpuEngine) {
+            float cellsPerPixel = gridWidth / (windowWidth * currentScale);
+
+            // The overview only mirrors the live board, so the rewind and
+            // diff views always render at full resolution
+            useCoarse = cellsPerPixel >= coarseCellsPerPixel && rewindOffset == 0 && !diffView;
+
+            if (useCoarse && lastCoarseGeneration != generationCount) {
+                glUseProgram(downsampleProgram);
+                glBindImageTexture(0, gpuEngineBoardTexture(), 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+                glBindImageTexture(1, coarseTexture, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R8UI);
+                glDispatchCompute((GLuint)(wordsPerRow + workgroupSize - 1) / workgroupSize, (GLuint)(coarseHeight + workgroupSize - 1) / workgroupSize, 1);
+
+                // The render pass samples what the downsample just wrote
+                glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+                lastCoarseGeneration = generationCount;
+            }
+        }
+
         // Clear the colour buffer
         // We're rendering a quad that covers the entire screen, so we could
         // *technically* get away with not doing this, but oh well, best practices.
@@ -344,24 +2680,174 @@ int main()
         glUseProgram(renderProgram);
         glBindVertexArray(quadVAO);
 
-        // The fragment shader expects the outputTexture to be in texture slot zero
-        // so bind it there
+        // The fragment shader expects the board to be in texture slot zero.
+        // We sample the renderer's own copy, never the ping-pong textures
         glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, outputTexture);
+        glBindTexture(GL_TEXTURE_2D, displayBoardTexture);
+
+        // On the CPU path, the texture is just a display surface - upload the
+        // engine's board into it now if it has moved on since last frame
+        if (useCpuEngine && cpuBoardDirty) {
+            int rowStrideWords;
+            const uint32_t* boardData = cpuEngineBoardData(&rowStrideWords);
+
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, rowStrideWords);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, wordsPerRow, gridHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, boardData);
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+            cpuBoardDirty = false;
+        }
         
+        // The heatmap view also samples the age texture from slot one, and
+        // the zoomed-out path the coarse overview from slot two
+        if (!useCpuEngine) {
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, gpuEngineAgeTexture());
+            glActiveTexture(GL_TEXTURE2);
+            glBindTexture(GL_TEXTURE_2D, coarseTexture);
+
+            if (historyDepth > 0) {
+                glActiveTexture(GL_TEXTURE3);
+                glBindTexture(GL_TEXTURE_2D_ARRAY, historyTexture);
+            }
+
+            glActiveTexture(GL_TEXTURE0);
+        }
+
         // Assign all our uniform values, so the shader knows the current visible viewport
         glUniform1f(scaleUniformLocation, currentScale);
         glUniform2f(offsetUniformLocation, currentXOffset, currentYOffset);
+        glUniform1i(displayModeUniformLocation, ageHeatmap ? 1 : 0);
+        glUniform1i(useCoarseUniformLocation, useCoarse ? 1 : 0);
+
+        // Which history layers the shader should use: the one on screen
+        // when rewinding (-1 = the live board), and the one to diff against
+        int historyLayer = -1;
+        int diffLayer = -1;
+
+        if (historyDepth > 0 && historyHead > 0) {
+            long long available = std::min(historyHead, (long long)historyDepth);
+
+            if (rewindOffset > 0)
+                historyLayer = historyLayerForOffset(rewindOffset);
+
+            if (diffView && rewindOffset + 1 < available)
+                diffLayer = historyLayerForOffset(rewindOffset + 1);
+        }
+
+        glUniform1i(historyLayerUniformLocation, historyLayer);
+        glUniform1i(diffLayerUniformLocation, diffLayer);
         
         // Actually draw our quad!
         // TODO: use an EBO to save on some vertices
+        glBeginQuery(GL_TIME_ELAPSED, renderQueries[queryFrame]);
         glDrawArrays(GL_TRIANGLES, 0, 6);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        // With the draw already in flight, run the frame's generations:
+        // paced by the wall clock when a target rate is set, the usual
+        // per-frame batch otherwise - or a single requested step while paused
+        int generationsThisFrame = 0;
+
+        if (simulationIsRunning) {
+            if (targetGenerationsPerSecond > 0.0f) {
+                generationDebt += (double)deltaTime * targetGenerationsPerSecond;
+
+                // After a long hiccup, catch up by at most a second's worth
+                // rather than digging the hole deeper trying to repay it all
+                if (generationDebt > targetGenerationsPerSecond)
+                    generationDebt = targetGenerationsPerSecond;
+
+                generationsThisFrame = (int)generationDebt;
+                generationDebt -= generationsThisFrame;
+            }
+            else {
+                generationsThisFrame = generationsPerFrame;
+            }
+        }
+        else if (singleStepRequested) {
+            generationsThisFrame = 1;
+        }
+
+        singleStepRequested = false;
+
+        if (generationsThisFrame > 0) {
+            glBeginQuery(GL_TIME_ELAPSED, computeQueries[queryFrame]);
+            simulationTick(generationsThisFrame);
+            glEndQuery(GL_TIME_ELAPSED);
+            computeQueryIssued[queryFrame] = true;
+
+            // The board has moved on, so any rewound view is out of date
+            rewindOffset = 0;
+        }
 
         glfwSwapBuffers(window);
         glfwPollEvents();
+
+        // Pick up last frame's timings. They're a frame stale, but that means
+        // the GPU has long finished them and the reads never block
+        if (frameNumber > 0 && (showTimings || csvFile.is_open())) {
+            int lastFrame = 1 - queryFrame;
+
+            GLuint64 computeNanoseconds = 0, renderNanoseconds = 0;
+
+            if (computeQueryIssued[lastFrame])
+                glGetQueryObjectui64v(computeQueries[lastFrame], GL_QUERY_RESULT, &computeNanoseconds);
+            glGetQueryObjectui64v(renderQueries[lastFrame], GL_QUERY_RESULT, &renderNanoseconds);
+
+            double computeMs = computeNanoseconds / 1e6;
+            double renderMs = renderNanoseconds / 1e6;
+
+            if (showTimings) {
+                char title[128];
+                snprintf(title, sizeof(title), "GameOfLife - compute %.3f ms, render %.3f ms, %d gen/frame", computeMs, renderMs, generationsPerFrame);
+                glfwSetWindowTitle(window, title);
+            }
+
+            if (csvFile.is_open())
+                csvFile << (frameNumber - 1) << "," << computeMs << "," << renderMs << std::endl;
+        }
+
+        frameNumber++;
     }
 
+    // Drain whatever census batches are still in flight before we go
+    if (censusFile.is_open())
+        pumpCensusReadbacks(true);
+
+    // Let the writer thread drain anything still queued, then stop it
+    if (checkpointWriterThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(checkpointQueueMutex);
+            checkpointWriterShouldExit = true;
+        }
+        checkpointQueueCondition.notify_one();
+        checkpointWriterThread.join();
+    }
+
+    // Same for the recorder, minus whatever readbacks never finished
+    if (recordWriterThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(recordQueueMutex);
+            recordWriterShouldExit = true;
+        }
+        recordQueueCondition.notify_one();
+        recordWriterThread.join();
+
+        if (droppedRecordFrames > 0)
+            std::cout << "Recorder dropped " << droppedRecordFrames << " frames (readbacks couldn't keep up)" << std::endl;
+    }
+
+    // Wind the band workers down before their contexts go away
+    if (numPartitions > 1)
+        shutdownPartitions();
+
     // Clean up everything
+    if (useCpuEngine)
+        cpuEngineShutdown();
+    else
+        gpuEngineShutdown();
+
     glfwDestroyWindow(window);
     glfwTerminate();
 }
\ No newline at end of file
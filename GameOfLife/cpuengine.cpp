@@ -0,0 +1,254 @@
+/*
+* cpuengine.cpp
+*
+* The CPU fallback simulation engine. See cpuengine.h for the interface.
+*
+* The board lives in two bit-packed buffers (64 cells per uint64_t word)
+* that ping-pong each generation, just like the GPU textures. Every row
+* carries one always-zero guard word at each end, and there's a guard row
+* above and below the board, so the inner loop never needs edge branches -
+* out-of-range neighbours simply read as dead.
+*/
+
+#include "cpuengine.h"
+
+#include <cstring>
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Board dimensions, in cells and in packed 64-bit words
+static int engineWidth = 0;
+static int engineHeight = 0;
+static int words64PerRow = 0;
+
+// Distance between the starts of consecutive rows, including the two guard
+// words
+static int rowStride = 0;
+
+// Which bits of the last word in each row are real cells
+static uint64_t lastWordMask64 = 0;
+
+// The two boards. frontBuffer always holds the latest generation
+static uint64_t* frontBuffer = NULL;
+static uint64_t* backBuffer = NULL;
+
+// A pointer to row y's first real (non-guard) word
+static inline uint64_t* rowPointer(uint64_t* buffer, int y)
+{
+    return buffer + (size_t)(y + 1) * rowStride + 1;
+}
+
+// Add a plane of single-bit values into four per-bit count planes - the same
+// bit-sliced ripple-carry adder as the compute shader, just 64 cells wide
+static inline void addPlane(uint64_t plane, uint64_t& count0, uint64_t& count1, uint64_t& count2, uint64_t& count3)
+{
+    uint64_t carry = count0 & plane;
+    count0 ^= plane;
+    plane = carry;
+
+    carry = count1 & plane;
+    count1 ^= plane;
+    plane = carry;
+
+    carry = count2 & plane;
+    count2 ^= plane;
+
+    count3 ^= carry;
+}
+
+#ifdef __AVX2__
+// The same adder again, four words (256 cells) at a time
+static inline void addPlaneAVX2(__m256i plane, __m256i& count0, __m256i& count1, __m256i& count2, __m256i& count3)
+{
+    __m256i carry = _mm256_and_si256(count0, plane);
+    count0 = _mm256_xor_si256(count0, plane);
+    plane = carry;
+
+    carry = _mm256_and_si256(count1, plane);
+    count1 = _mm256_xor_si256(count1, plane);
+    plane = carry;
+
+    carry = _mm256_and_si256(count2, plane);
+    count2 = _mm256_xor_si256(count2, plane);
+
+    count3 = _mm256_xor_si256(count3, carry);
+}
+#endif
+
+// Compute one word of the next generation from the three source rows around it
+static inline uint64_t stepWord(const uint64_t* above, const uint64_t* same, const uint64_t* below, int i)
+{
+    uint64_t count0 = 0, count1 = 0, count2 = 0, count3 = 0;
+    const uint64_t* rows[3] = { above, same, below };
+
+    for (int r = 0; r < 3; r++) {
+        uint64_t centre = rows[r][i];
+
+        // The west neighbour of bit i is bit i - 1, so shift the word up by
+        // one and pull the missing bit in from the word to the left (and
+        // mirrored for east) - the guard words make i-1 and i+1 always valid
+        addPlane((centre << 1) | (rows[r][i - 1] >> 63), count0, count1, count2, count3);
+        addPlane((centre >> 1) | (rows[r][i + 1] << 63), count0, count1, count2, count3);
+
+        // The cell itself isn't its own neighbour
+        if (r != 1)
+            addPlane(centre, count0, count1, count2, count3);
+    }
+
+    uint64_t hasThree = count0 & count1 & ~count2 & ~count3;
+    uint64_t hasTwo = ~count0 & count1 & ~count2 & ~count3;
+
+    return hasThree | (same[i] & hasTwo);
+}
+
+// Advance one generation for the rows in [startRow, endRow)
+static void tickBand(const uint64_t* source, uint64_t* destination, int startRow, int endRow)
+{
+    for (int y = startRow; y < endRow; y++) {
+        const uint64_t* above = rowPointer((uint64_t*)source, y - 1);
+        const uint64_t* same = rowPointer((uint64_t*)source, y);
+        const uint64_t* below = rowPointer((uint64_t*)source, y + 1);
+        uint64_t* out = rowPointer(destination, y);
+
+        int i = 0;
+
+#ifdef __AVX2__
+        // Vectorized inner loop: four words (256 cells) per iteration. The
+        // cross-word carries become unaligned loads one word to either side
+        for (; i + 4 <= words64PerRow; i += 4) {
+            __m256i count0 = _mm256_setzero_si256();
+            __m256i count1 = _mm256_setzero_si256();
+            __m256i count2 = _mm256_setzero_si256();
+            __m256i count3 = _mm256_setzero_si256();
+
+            const uint64_t* rows[3] = { above, same, below };
+
+            for (int r = 0; r < 3; r++) {
+                __m256i centre = _mm256_loadu_si256((const __m256i*)(rows[r] + i));
+                __m256i left = _mm256_loadu_si256((const __m256i*)(rows[r] + i - 1));
+                __m256i right = _mm256_loadu_si256((const __m256i*)(rows[r] + i + 1));
+
+                __m256i west = _mm256_or_si256(_mm256_slli_epi64(centre, 1), _mm256_srli_epi64(left, 63));
+                __m256i east = _mm256_or_si256(_mm256_srli_epi64(centre, 1), _mm256_slli_epi64(right, 63));
+
+                addPlaneAVX2(west, count0, count1, count2, count3);
+                addPlaneAVX2(east, count0, count1, count2, count3);
+
+                if (r != 1)
+                    addPlaneAVX2(centre, count0, count1, count2, count3);
+            }
+
+            __m256i notHigh = _mm256_andnot_si256(_mm256_or_si256(count2, count3), _mm256_set1_epi64x(-1));
+            __m256i hasThree = _mm256_and_si256(_mm256_and_si256(count0, count1), notHigh);
+            __m256i hasTwo = _mm256_and_si256(_mm256_andnot_si256(count0, count1), notHigh);
+
+            __m256i oldState = _mm256_loadu_si256((const __m256i*)(same + i));
+            __m256i newState = _mm256_or_si256(hasThree, _mm256_and_si256(oldState, hasTwo));
+
+            _mm256_storeu_si256((__m256i*)(out + i), newState);
+        }
+#endif
+
+        // Whatever's left (everything, without AVX2) one word at a time
+        for (; i < words64PerRow; i++)
+            out[i] = stepWord(above, same, below, i);
+
+        // Keep the padding bits past the board width dead
+        out[words64PerRow - 1] &= lastWordMask64;
+    }
+}
+
+void cpuEngineInit(int width, int height, const uint32_t* packedBoard, int inputWordsPerRow)
+{
+    engineWidth = width;
+    engineHeight = height;
+    words64PerRow = (width + 63) / 64;
+    rowStride = words64PerRow + 2;
+    lastWordMask64 = (width % 64 == 0) ? ~0ull : ((1ull << (width % 64)) - 1);
+
+    // Guard rows above and below, guard words left and right, all zero
+    size_t bufferWords = (size_t)(height + 2) * rowStride;
+    frontBuffer = new uint64_t[bufferWords]();
+    backBuffer = new uint64_t[bufferWords]();
+
+    // Widen the 32-bit packed input into our 64-bit words
+    for (int y = 0; y < height; y++) {
+        const uint32_t* sourceRow = packedBoard + (size_t)y * inputWordsPerRow;
+        uint64_t* row = rowPointer(frontBuffer, y);
+
+        for (int i = 0; i < words64PerRow; i++) {
+            uint64_t low = sourceRow[2 * i];
+            uint64_t high = (2 * i + 1 < inputWordsPerRow) ? sourceRow[2 * i + 1] : 0;
+            row[i] = low | (high << 32);
+        }
+    }
+}
+
+void cpuEngineTick(int generations)
+{
+    // One band of rows per hardware thread. The threads are respawned per
+    // generation - that overhead is tiny next to the work on any board big
+    // enough to be worth multithreading
+    int numThreads = std::max(1, std::min((int)std::thread::hardware_concurrency(), engineHeight));
+    int rowsPerBand = (engineHeight + numThreads - 1) / numThreads;
+
+    for (int generation = 0; generation < generations; generation++) {
+        std::vector<std::thread> threads;
+
+        for (int band = 0; band < numThreads; band++) {
+            int startRow = band * rowsPerBand;
+            int endRow = std::min(startRow + rowsPerBand, engineHeight);
+
+            if (startRow < endRow)
+                threads.push_back(std::thread(tickBand, frontBuffer, backBuffer, startRow, endRow));
+        }
+
+        for (std::thread& thread : threads)
+            thread.join();
+
+        std::swap(frontBuffer, backBuffer);
+    }
+}
+
+const uint32_t* cpuEngineBoardData(int* rowStrideWords)
+{
+    *rowStrideWords = rowStride * 2;
+    return (const uint32_t*)rowPointer(frontBuffer, 0);
+}
+
+void cpuEngineCopyBoard(uint32_t* destination)
+{
+    int wordsPerRow32 = (engineWidth + 31) / 32;
+
+    for (int y = 0; y < engineHeight; y++) {
+        const uint32_t* row = (const uint32_t*)rowPointer(frontBuffer, y);
+        std::memcpy(destination + (size_t)y * wordsPerRow32, row, (size_t)wordsPerRow32 * sizeof(uint32_t));
+    }
+}
+
+void cpuEngineSetCell(int x, int y, bool alive)
+{
+    if (x < 0 || x >= engineWidth || y < 0 || y >= engineHeight)
+        return;
+
+    uint64_t* row = rowPointer(frontBuffer, y);
+    uint64_t bit = 1ull << (x % 64);
+
+    if (alive)
+        row[x / 64] |= bit;
+    else
+        row[x / 64] &= ~bit;
+}
+
+void cpuEngineShutdown()
+{
+    delete[] frontBuffer;
+    delete[] backBuffer;
+    frontBuffer = NULL;
+    backBuffer = NULL;
+}
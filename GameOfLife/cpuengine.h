@@ -0,0 +1,37 @@
+/*
+* cpuengine.h
+*
+* A bit-packed CPU implementation of the Game of Life update, used as a
+* fallback on machines whose drivers can't give us the OpenGL 4.3 compute
+* shaders the GPU path needs. Cells are packed 64 to a word and updated with
+* the same bit-sliced adder trick as gameoflife.comp (with an AVX2 version
+* when the compiler is allowed to emit it), multithreaded across row bands.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Allocate the engine's boards and load the packed inital state, which uses
+// the same 32-cells-per-word layout as the textures (inputWordsPerRow words
+// per row)
+void cpuEngineInit(int width, int height, const uint32_t* packedBoard, int inputWordsPerRow);
+
+// Advance the board the given number of generations
+void cpuEngineTick(int generations);
+
+// A pointer to the latest board as 32-bit words, suitable for texture
+// upload. Rows are rowStrideWords words apart (set GL_UNPACK_ROW_LENGTH
+// accordingly - the stride includes the engine's internal guard words)
+const uint32_t* cpuEngineBoardData(int* rowStrideWords);
+
+// Copy the latest board into a tightly-packed buffer of
+// ceil(width / 32) * height words, e.g. for writing a checkpoint
+void cpuEngineCopyBoard(uint32_t* destination);
+
+// Set a single cell of the latest board - the interactive editing path.
+// Out-of-range coordinates are quietly ignored
+void cpuEngineSetCell(int x, int y, bool alive);
+
+// Free the engine's boards
+void cpuEngineShutdown();
@@ -0,0 +1,481 @@
+/*
+* gpuengine.cpp
+*
+* The compute-shader simulation engine: the ping-pong board textures, the
+* age texture, the activity tracking buffers, the kernel and scheduler
+* programs, and the per-generation dispatch logic. See gpuengine.h for the
+* interface and the ownership rules.
+*/
+
+#include "gpuengine.h"
+#include "shaderprograms.h"
+
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// The board the engine is simulating, in cells and in packed words per row
+static int boardWidth = 0;
+static int boardHeight = 0;
+static int wordsPerRow = 0;
+
+// The two board textures. Each step reads one and writes the other, then the
+// roles swap - no copying involved
+static GLuint boardTextures[2];
+
+// Which of boardTextures currently holds the latest generation
+static int latestBoard = 0;
+
+// The per-cell age texture backing the heatmap view. Full resolution - a
+// byte per cell - but only ever touched while trackAge is set
+static GLuint ageTexture;
+
+// Two per-tile activity flag buffers (last generation's and this
+// generation's), the scheduler's tile list, and the indirect dispatch
+// command it builds
+static GLuint activityBuffers[2], tileListBuffer, indirectBuffer;
+static int latestActivity = 0;
+
+// The kernel and the sparse scheduler
+static GLuint computeProgram, scheduleProgram;
+
+// The kernel's workgroup edge length in words, and how many workgroup-sized
+// tiles the board splits into along each axis
+static int kernelWorkgroupSize = 16;
+static int numTilesX = 0, numTilesY = 0;
+
+// The scheduler keeps the fixed 16x16 shape declared in its source - only
+// the kernel's shape is tunable
+static const int schedulerWorkgroupSize = 16;
+
+// Uniform locations for the kernel's per-step switches
+static GLint sparseModeUniformLocation = -1;
+static GLint trackAgeUniformLocation = -1;
+static GLint dispatchOriginUniformLocation = -1;
+
+// Measure which workgroup edge length runs the kernel fastest on this GPU.
+// The spread between shapes can be severalfold across vendors, so it's worth
+// a one-off measurement: each candidate gets compiled through the usual
+// prelude splicing, warmed up, and timed over a handful of generations on
+// scratch boards the size of the real one. The winner lands in a little text
+// file alongside the shader binaries, keyed the same way (renderer plus
+// driver version), so every later launch skips straight to it
+static int autotuneWorkgroupSize(const char* rulePrelude)
+{
+    const int candidates[] = { 8, 16, 32 };
+
+    uint64_t cacheKey = 14695981039346656037ull;
+    cacheKey = hashString(cacheKey, (const char*)glGetString(GL_RENDERER));
+    cacheKey = hashString(cacheKey, (const char*)glGetString(GL_VERSION));
+
+    char cachePath[64];
+    snprintf(cachePath, sizeof(cachePath), "shadercache/%016llx.tune", (unsigned long long)cacheKey);
+
+    {
+        std::ifstream cacheFile(cachePath);
+        int cachedSize = 0;
+
+        if (cacheFile >> cachedSize) {
+            for (int candidate : candidates) {
+                if (cachedSize == candidate)
+                    return cachedSize;
+            }
+        }
+    }
+
+    std::cout << "Tuning the kernel workgroup size for " << glGetString(GL_RENDERER) << "..." << std::endl;
+
+    // 32x32 is 1024 invocations, which is only the spec's guaranteed minimum
+    GLint maxInvocations = 0;
+    glGetIntegerv(GL_MAX_COMPUTE_WORK_GROUP_INVOCATIONS, &maxInvocations);
+
+    // Scratch ping-pong boards (zeroed - the kernel's cost doesn't depend on
+    // the cell pattern) and an activity buffer sized for the smallest
+    // candidate, which has the most tiles
+    GLuint scratchTextures[2];
+    glGenTextures(2, scratchTextures);
+
+    std::vector<uint32_t> zeroBoard((size_t)wordsPerRow * boardHeight, 0);
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, scratchTextures[i]);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, wordsPerRow, boardHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, zeroBoard.data());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    }
+
+    int maxTiles = ((wordsPerRow + candidates[0] - 1) / candidates[0]) * ((boardHeight + candidates[0] - 1) / candidates[0]);
+    GLuint scratchActivity;
+    glGenBuffers(1, &scratchActivity);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, scratchActivity);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (size_t)maxTiles * sizeof(uint32_t), NULL, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    GLuint timerQuery;
+    glGenQueries(1, &timerQuery);
+
+    int bestSize = 16;
+    GLuint64 bestTime = 0;
+
+    for (int candidate : candidates) {
+        if (candidate * candidate > maxInvocations)
+            continue;
+
+        char prelude[160];
+        snprintf(prelude, sizeof(prelude), "%s#define WORKGROUP_SIZE %d\n", rulePrelude, candidate);
+
+        const char* computePath = "gameoflife.comp";
+        const GLenum computeType = GL_COMPUTE_SHADER;
+        GLuint program = loadProgramCached(&computePath, &computeType, 1, prelude);
+
+        glUseProgram(program);
+        glUniform1ui(glGetUniformLocation(program, "lastWordMask"),
+                     (boardWidth % 32 == 0) ? 0xFFFFFFFFu : ((1u << (boardWidth % 32)) - 1));
+        glUniform1i(glGetUniformLocation(program, "sparseMode"), 0);
+        glUniform1i(glGetUniformLocation(program, "trackAge"), 0);
+        glUniform1i(glGetUniformLocation(program, "boundaryMode"), 0);
+
+        glBindImageTexture(0, scratchTextures[0], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+        glBindImageTexture(1, scratchTextures[1], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, scratchActivity);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, scratchActivity);
+
+        GLuint groupsX = (GLuint)((wordsPerRow + candidate - 1) / candidate);
+        GLuint groupsY = (GLuint)((boardHeight + candidate - 1) / candidate);
+
+        // A couple of untimed generations first, so clocks ramp up and the
+        // driver finishes any lazy setup before the stopwatch starts
+        for (int i = 0; i < 2; i++) {
+            glDispatchCompute(groupsX, groupsY, 1);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+        glFinish();
+
+        glBeginQuery(GL_TIME_ELAPSED, timerQuery);
+        for (int i = 0; i < 8; i++) {
+            glDispatchCompute(groupsX, groupsY, 1);
+            glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT);
+        }
+        glEndQuery(GL_TIME_ELAPSED);
+
+        // Fetching the result waits for the GPU, which is exactly what the
+        // stopwatch needs here
+        GLuint64 elapsed = 0;
+        glGetQueryObjectui64v(timerQuery, GL_QUERY_RESULT, &elapsed);
+        glDeleteProgram(program);
+
+        std::cout << "    " << candidate << "x" << candidate << ": " << (elapsed / 1000000.0) << " ms" << std::endl;
+
+        if (bestTime == 0 || elapsed < bestTime) {
+            bestTime = elapsed;
+            bestSize = candidate;
+        }
+    }
+
+    glDeleteQueries(1, &timerQuery);
+    glDeleteBuffers(1, &scratchActivity);
+    glDeleteTextures(2, scratchTextures);
+
+#ifdef _WIN32
+    _mkdir("shadercache");
+#else
+    mkdir("shadercache", 0755);
+#endif
+
+    std::ofstream cacheFile(cachePath, std::ios::trunc);
+    cacheFile << bestSize << "\n";
+
+    std::cout << "Using " << bestSize << "x" << bestSize << " workgroups" << std::endl;
+
+    return bestSize;
+}
+
+void gpuEngineInit(int width, int height, uint32_t birthMask, uint32_t surviveMask, int boundaryMode, int workgroupSize)
+{
+    boardWidth = width;
+    boardHeight = height;
+    wordsPerRow = (width + 31) / 32;
+
+    // The rule masks get spliced into the kernel as compile-time constants,
+    // so each rule links (and caches) as its own program
+    char rulePrelude[96];
+    snprintf(rulePrelude, sizeof(rulePrelude),
+             "#define BIRTH_MASK 0x%03Xu\n#define SURVIVE_MASK 0x%03Xu\n", birthMask, surviveMask);
+
+    // Pick the kernel's workgroup shape for this GPU - measured on the first
+    // run per device, cached after that - unless the caller fixed one
+    kernelWorkgroupSize = workgroupSize != 0 ? workgroupSize : autotuneWorkgroupSize(rulePrelude);
+
+    char kernelPrelude[160];
+    snprintf(kernelPrelude, sizeof(kernelPrelude),
+             "%s#define WORKGROUP_SIZE %d\n", rulePrelude, kernelWorkgroupSize);
+
+    const char* computePath = "gameoflife.comp";
+    const char* schedulePath = "schedule.comp";
+    const GLenum computeType = GL_COMPUTE_SHADER;
+
+    computeProgram = loadProgramCached(&computePath, &computeType, 1, kernelPrelude);
+    scheduleProgram = loadProgramCached(&schedulePath, &computeType, 1);
+
+    // Create the two board textures for the kernel to ping-pong between,
+    // starting all dead - the caller uploads its real board when it has one.
+    // Integer textures have to use GL_NEAREST, which is what we'd pick
+    // anyway - we're essentially rendering pixel art
+    std::vector<uint32_t> zeroBoard((size_t)wordsPerRow * boardHeight, 0);
+
+    glGenTextures(2, boardTextures);
+
+    for (int i = 0; i < 2; i++) {
+        glBindTexture(GL_TEXTURE_2D, boardTextures[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_R32UI, wordsPerRow, boardHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, zeroBoard.data());
+    }
+
+    // The per-cell age texture, zeroed so every cell starts newborn
+    std::vector<uint8_t> zeroAges((size_t)boardWidth * boardHeight, 0);
+
+    glGenTextures(1, &ageTexture);
+    glBindTexture(GL_TEXTURE_2D, ageTexture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8UI, boardWidth, boardHeight, 0, GL_RED_INTEGER, GL_UNSIGNED_BYTE, zeroAges.data());
+
+    // The board textures swap slots every step, but the age image can stay
+    // bound to slot two permanently
+    glBindImageTexture(2, ageTexture, 0, GL_FALSE, 0, GL_READ_WRITE, GL_R8UI);
+
+    // Tell the kernel which bits of the last word in each row are real
+    // cells, so it can keep the padding bits dead
+    glUseProgram(computeProgram);
+    GLuint lastWordMask = (boardWidth % 32 == 0) ? 0xFFFFFFFFu : ((1u << (boardWidth % 32)) - 1);
+    glUniform1ui(glGetUniformLocation(computeProgram, "lastWordMask"), lastWordMask);
+    sparseModeUniformLocation = glGetUniformLocation(computeProgram, "sparseMode");
+    trackAgeUniformLocation = glGetUniformLocation(computeProgram, "trackAge");
+    dispatchOriginUniformLocation = glGetUniformLocation(computeProgram, "dispatchOrigin");
+    glUniform1i(glGetUniformLocation(computeProgram, "boundaryMode"), boundaryMode);
+
+    // Split the board into workgroup-sized tiles for activity tracking
+    numTilesX = (wordsPerRow + kernelWorkgroupSize - 1) / kernelWorkgroupSize;
+    numTilesY = (boardHeight + kernelWorkgroupSize - 1) / kernelWorkgroupSize;
+
+    // Create the per-tile activity flag buffers (starting all-active, so
+    // the first generations simulate everything), the scheduler's tile
+    // list, and the indirect dispatch command buffer
+    std::vector<uint32_t> allActive((size_t)numTilesX * numTilesY, 1);
+
+    glGenBuffers(2, activityBuffers);
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityBuffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, allActive.size() * sizeof(uint32_t), allActive.data(), GL_DYNAMIC_COPY);
+    }
+
+    glGenBuffers(1, &tileListBuffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, tileListBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, allActive.size() * sizeof(uint32_t), NULL, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    GLuint initialCommand[3] = { 0, 1, 1 };
+    glGenBuffers(1, &indirectBuffer);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirectBuffer);
+    glBufferData(GL_DISPATCH_INDIRECT_BUFFER, sizeof(initialCommand), initialCommand, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, 0);
+
+    // The scheduler needs to know the tile grid dimensions
+    glUseProgram(scheduleProgram);
+    glUniform2i(glGetUniformLocation(scheduleProgram, "numTiles"), numTilesX, numTilesY);
+    glUniform1i(glGetUniformLocation(scheduleProgram, "boundaryMode"), boundaryMode);
+}
+
+// The shared head and tail of a step: reset this generation's activity
+// flags, bind the kernel's images and buffers, and (after the dispatch)
+// order the writes ahead of the next step's reads and swap the roles
+static void beginStep(bool sparse, bool trackAge)
+{
+    // Reset this generation's activity flags - tiles that don't get
+    // simulated (or don't change) should read as inactive next generation
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityBuffers[1 - latestActivity]);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    glUseProgram(computeProgram);
+    glUniform1i(sparseModeUniformLocation, sparse ? 1 : 0);
+    glUniform1i(trackAgeUniformLocation, trackAge ? 1 : 0);
+
+    // Read the latest generation from image slot zero, and write the new
+    // generation into image slot one
+    glBindImageTexture(0, boardTextures[latestBoard], 0, GL_FALSE, 0, GL_READ_ONLY, GL_R32UI);
+    glBindImageTexture(1, boardTextures[1 - latestBoard], 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32UI);
+
+    // The kernel flags tiles that changed into this generation's activity
+    // buffer, and (when sparse) reads its tile assignments from the list
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, activityBuffers[1 - latestActivity]);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, tileListBuffer);
+}
+
+static void endStep()
+{
+    // Make sure the kernel has finished writing before the next step's
+    // scheduler and dispatch read the results
+    glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // What we just wrote is now the latest generation - swap the roles
+    // rather than copying anything
+    latestBoard = 1 - latestBoard;
+    latestActivity = 1 - latestActivity;
+}
+
+void gpuEngineStep(bool sparse, bool trackAge)
+{
+    if (sparse) {
+        // Reset the indirect dispatch command before the scheduler starts
+        // counting tiles into it
+        GLuint emptyCommand[3] = { 0, 1, 1 };
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirectBuffer);
+        glBufferSubData(GL_DISPATCH_INDIRECT_BUFFER, 0, sizeof(emptyCommand), emptyCommand);
+
+        // Build the list of tiles that could change this generation out
+        // of last generation's activity flags
+        glUseProgram(scheduleProgram);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, activityBuffers[latestActivity]);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, tileListBuffer);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, indirectBuffer);
+        glDispatchCompute((GLuint)(numTilesX + schedulerWorkgroupSize - 1) / schedulerWorkgroupSize,
+                          (GLuint)(numTilesY + schedulerWorkgroupSize - 1) / schedulerWorkgroupSize, 1);
+
+        // The main kernel reads the tile list, and the GPU front end
+        // reads the dispatch command itself
+        glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT | GL_COMMAND_BARRIER_BIT);
+    }
+
+    beginStep(sparse, trackAge);
+
+    // Each invocation handles a whole word of cells, and invocations come
+    // in workgroup-sized tiles - the kernel masks off any invocations that
+    // fall past the edge of the board
+    if (sparse) {
+        glBindBuffer(GL_DISPATCH_INDIRECT_BUFFER, indirectBuffer);
+        glDispatchComputeIndirect(0);
+    }
+    else {
+        glUniform2i(dispatchOriginUniformLocation, 0, 0);
+        glDispatchCompute((GLuint)numTilesX, (GLuint)numTilesY, 1);
+    }
+
+    endStep();
+}
+
+void gpuEngineStepRegion(int firstTileX, int firstTileY, int lastTileX, int lastTileY, bool trackAge)
+{
+    // Intersect the window with the board's tile grid. Callers track a
+    // viewport that can sit entirely off the board, and an inverted window
+    // would underflow the unsigned dispatch counts below
+    firstTileX = std::max(firstTileX, 0);
+    firstTileY = std::max(firstTileY, 0);
+    lastTileX = std::min(lastTileX, numTilesX - 1);
+    lastTileY = std::min(lastTileY, numTilesY - 1);
+
+    // Nothing in range: skip the whole step, before the ping-pong swap, so
+    // the board legitimately holds still this generation
+    if (firstTileX > lastTileX || firstTileY > lastTileY)
+        return;
+
+    beginStep(false, trackAge);
+
+    glUniform2i(dispatchOriginUniformLocation, firstTileX, firstTileY);
+    glDispatchCompute((GLuint)(lastTileX - firstTileX + 1), (GLuint)(lastTileY - firstTileY + 1), 1);
+
+    endStep();
+}
+
+GLuint gpuEngineBoardTexture()
+{
+    return boardTextures[latestBoard];
+}
+
+GLuint gpuEngineAgeTexture()
+{
+    return ageTexture;
+}
+
+GLuint gpuEngineKernelProgram()
+{
+    return computeProgram;
+}
+
+GLuint gpuEngineActivityBuffer()
+{
+    return activityBuffers[latestActivity];
+}
+
+GLuint gpuEngineTileListBuffer()
+{
+    return tileListBuffer;
+}
+
+int gpuEngineWorkgroupSize()
+{
+    return kernelWorkgroupSize;
+}
+
+int gpuEngineTilesX()
+{
+    return numTilesX;
+}
+
+int gpuEngineTilesY()
+{
+    return numTilesY;
+}
+
+void gpuEngineUpload(const uint32_t* packedBoard)
+{
+    glBindTexture(GL_TEXTURE_2D, boardTextures[latestBoard]);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, wordsPerRow, boardHeight, GL_RED_INTEGER, GL_UNSIGNED_INT, packedBoard);
+}
+
+void gpuEngineReadback(uint32_t* packedBoard)
+{
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glBindTexture(GL_TEXTURE_2D, boardTextures[latestBoard]);
+    glGetTexImage(GL_TEXTURE_2D, 0, GL_RED_INTEGER, GL_UNSIGNED_INT, packedBoard);
+}
+
+void gpuEngineMirrorBoard()
+{
+    glMemoryBarrier(GL_TEXTURE_UPDATE_BARRIER_BIT);
+    glCopyImageSubData(boardTextures[latestBoard], GL_TEXTURE_2D, 0, 0, 0, 0,
+                       boardTextures[1 - latestBoard], GL_TEXTURE_2D, 0, 0, 0, 0,
+                       wordsPerRow, boardHeight, 1);
+}
+
+void gpuEngineWakeAllTiles()
+{
+    // Every tile might be stale, so mark the lot active in both flag
+    // buffers and let the scheduler sort things out from scratch
+    std::vector<uint32_t> allActive((size_t)numTilesX * numTilesY, 1);
+
+    for (int i = 0; i < 2; i++) {
+        glBindBuffer(GL_SHADER_STORAGE_BUFFER, activityBuffers[i]);
+        glBufferData(GL_SHADER_STORAGE_BUFFER, allActive.size() * sizeof(uint32_t), allActive.data(), GL_DYNAMIC_COPY);
+    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void gpuEngineShutdown()
+{
+    glDeleteTextures(2, boardTextures);
+    glDeleteTextures(1, &ageTexture);
+    glDeleteBuffers(2, activityBuffers);
+    glDeleteBuffers(1, &tileListBuffer);
+    glDeleteBuffers(1, &indirectBuffer);
+    glDeleteProgram(computeProgram);
+    glDeleteProgram(scheduleProgram);
+}
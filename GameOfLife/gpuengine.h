@@ -0,0 +1,80 @@
+/*
+* gpuengine.h
+*
+* The compute-shader simulation engine, factored out of the app so headless
+* embedders (census workers, streamers, the benchmark) can step a board
+* without dragging the window, input and rendering code along. The engine
+* owns the ping-pong board textures, the per-cell age texture, the activity
+* tracking buffers and the kernel and scheduler programs; the caller owns
+* the GL context (4.3 or newer, current on the calling thread) and whatever
+* presentation it wants to hang off the accessors below.
+*/
+
+#pragma once
+
+#include <glad/gl.h>
+
+#include <cstdint>
+
+// Create the engine's textures, buffers and programs for a width x height
+// cell board. The rule arrives as B/S bitmasks (bit n = neighbour count n)
+// and gets compiled into the kernel; boundaryMode is 0 for dead edges, 1
+// for toroidal wrap, 2 for reflection. workgroupSize picks the kernel's
+// workgroup edge length in words - pass 0 to have the best shape measured
+// once per GPU and cached. The board starts empty; see gpuEngineUpload
+void gpuEngineInit(int width, int height, uint32_t birthMask, uint32_t surviveMask, int boundaryMode, int workgroupSize);
+
+// Advance one generation. With sparse set, the scheduler pass narrows the
+// dispatch to the tiles that could change; trackAge maintains the age
+// texture (it costs a per-cell pass, so only ask while something reads it)
+void gpuEngineStep(bool sparse, bool trackAge);
+
+// Advance one generation of just the given inclusive window of tiles,
+// leaving the rest of the board untouched. The window is clipped to the
+// board's tile grid, and an empty intersection steps nothing at all.
+// Cells at the window's edge read frozen neighbours, so the result is
+// approximate there - the caller picks a window with whatever slack its
+// use can live with
+void gpuEngineStepRegion(int firstTileX, int firstTileY, int lastTileX, int lastTileY, bool trackAge);
+
+// The texture holding the latest generation (changes identity every step -
+// re-fetch rather than caching). Bit-packed R32UI, ceil(width / 32) texels
+// per row, rows bottom-to-top
+GLuint gpuEngineBoardTexture();
+
+// The per-cell age texture the kernel maintains while trackAge is set
+GLuint gpuEngineAgeTexture();
+
+// The kernel program itself, for callers that dispatch it on their own
+// textures (the partitioned mode's band workers)
+GLuint gpuEngineKernelProgram();
+
+// The activity flag buffer the next step's scheduler will read, so edit
+// passes can wake the tiles they touch - and the scheduler's tile list
+GLuint gpuEngineActivityBuffer();
+GLuint gpuEngineTileListBuffer();
+
+// The kernel's workgroup edge length in words (fixed after init), and how
+// many workgroup-sized tiles the board splits into along each axis
+int gpuEngineWorkgroupSize();
+int gpuEngineTilesX();
+int gpuEngineTilesY();
+
+// Replace the board with a tightly-packed ceil(width / 32) * height word
+// image, and read the latest board back into one (synchronously - callers
+// on a hot path should prefer their own fenced pack-buffer readbacks
+// against gpuEngineBoardTexture())
+void gpuEngineUpload(const uint32_t* packedBoard);
+void gpuEngineReadback(uint32_t* packedBoard);
+
+// Copy the latest board over its ping-pong partner, so a region-limited
+// caller sees identical cells from either texture before it starts leaving
+// tiles undispatched
+void gpuEngineMirrorBoard();
+
+// Mark every tile active, forcing the next sparse steps to look at the
+// whole board - after bulk edits, or when a frozen region thaws
+void gpuEngineWakeAllTiles();
+
+// Delete the engine's GL objects
+void gpuEngineShutdown();
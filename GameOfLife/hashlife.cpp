@@ -0,0 +1,331 @@
+/*
+* hashlife.cpp
+*
+* The HashLife-style fast-forward engine declared in hashlife.h.
+*
+* The board lives in a quadtree: a level-n node covers a 2^n x 2^n square,
+* with four level-(n-1) children and a single-cell leaf at level 0. Nodes
+* are hash-consed - two identical squares anywhere in the board (or at any
+* point in time) are one shared node - and every node memoizes the result
+* of advancing its centre, so repeated structure is only ever simulated
+* once. See Gosper's original algorithm, or Rokicki's write-up of it, for
+* why the recursion below advances time the way it does.
+*/
+
+#include "hashlife.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+// A quadtree node. Children are in the order nw, ne, sw, se; leaves have
+// no children and a population of 0 or 1
+struct Node {
+    Node* children[4];
+    int level;
+    long long population;
+
+    // Memoized results of advance(): step exponent -> the centre of this
+    // node advanced 2^exponent generations
+    std::unordered_map<int, Node*> results;
+};
+
+// The two canonical leaves
+static Node* deadCell;
+static Node* liveCell;
+
+// The hash-consing table: four children identify a node completely
+struct NodeKey {
+    Node* children[4];
+
+    bool operator==(const NodeKey& other) const {
+        return children[0] == other.children[0] && children[1] == other.children[1]
+            && children[2] == other.children[2] && children[3] == other.children[3];
+    }
+};
+
+struct NodeKeyHash {
+    size_t operator()(const NodeKey& key) const {
+        // Mix the four pointers FNV-1a style
+        size_t hash = 14695981039346656037ull;
+        for (int i = 0; i < 4; i++) {
+            hash ^= (size_t)key.children[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+};
+
+static std::unordered_map<NodeKey, Node*, NodeKeyHash> nodeTable;
+
+// Every node ever made, so the whole arena can be freed at the end
+static std::vector<Node*> allNodes;
+
+// The canonical all-dead node of each level
+static std::vector<Node*> emptyNodes;
+
+// The node for the given four children, reused if it already exists
+static Node* join(Node* nw, Node* ne, Node* sw, Node* se)
+{
+    NodeKey key = { { nw, ne, sw, se } };
+
+    auto existing = nodeTable.find(key);
+    if (existing != nodeTable.end())
+        return existing->second;
+
+    Node* node = new Node();
+    node->children[0] = nw;
+    node->children[1] = ne;
+    node->children[2] = sw;
+    node->children[3] = se;
+    node->level = nw->level + 1;
+    node->population = nw->population + ne->population + sw->population + se->population;
+
+    nodeTable[key] = node;
+    allNodes.push_back(node);
+    return node;
+}
+
+static Node* makeLeaf(long long population)
+{
+    Node* leaf = new Node();
+    leaf->children[0] = leaf->children[1] = leaf->children[2] = leaf->children[3] = NULL;
+    leaf->level = 0;
+    leaf->population = population;
+
+    allNodes.push_back(leaf);
+    return leaf;
+}
+
+static Node* emptyNode(int level)
+{
+    while ((int)emptyNodes.size() <= level) {
+        if (emptyNodes.empty())
+            emptyNodes.push_back(deadCell);
+        else {
+            Node* below = emptyNodes.back();
+            emptyNodes.push_back(join(below, below, below, below));
+        }
+    }
+
+    return emptyNodes[level];
+}
+
+// The centred level-(n-1) square of a level-n node
+static Node* centre(Node* node)
+{
+    return join(node->children[0]->children[3], node->children[1]->children[2],
+                node->children[2]->children[1], node->children[3]->children[0]);
+}
+
+// Wrap a node in a ring of dead cells, one level up, keeping it centred
+static Node* expand(Node* node)
+{
+    Node* border = emptyNode(node->level - 1);
+
+    return join(join(border, border, border, node->children[0]),
+                join(border, border, node->children[1], border),
+                join(border, node->children[2], border, border),
+                join(node->children[3], border, border, border));
+}
+
+// Read one cell of a small node, with (0, 0) in its top-left corner
+static int cellAt(Node* node, int x, int y)
+{
+    if (node->level == 0)
+        return node->population != 0;
+
+    int half = 1 << (node->level - 1);
+    int quadrant = (y >= half ? 2 : 0) + (x >= half ? 1 : 0);
+
+    return cellAt(node->children[quadrant], x & (half - 1), y & (half - 1));
+}
+
+// The recursion's base case: advance a level-2 (4x4) node one generation
+// by brute force, giving its 2x2 centre
+static Node* advance4x4(Node* node)
+{
+    Node* cells[4];
+
+    for (int y = 1; y <= 2; y++) {
+        for (int x = 1; x <= 2; x++) {
+            int neighbours = 0;
+
+            for (int dy = -1; dy <= 1; dy++)
+                for (int dx = -1; dx <= 1; dx++)
+                    if (dx != 0 || dy != 0)
+                        neighbours += cellAt(node, x + dx, y + dy);
+
+            bool alive = neighbours == 3 || (neighbours == 2 && cellAt(node, x, y));
+            cells[(y - 1) * 2 + (x - 1)] = alive ? liveCell : deadCell;
+        }
+    }
+
+    return join(cells[0], cells[1], cells[2], cells[3]);
+}
+
+// Advance the centre of a node 2^stepExponent generations, where the
+// exponent is at most level - 2. This is the heart of HashLife: split the
+// node into nine overlapping half-sized squares, advance those, reassemble
+// four quadrants out of the results and advance them too. At full speed
+// (exponent == level - 2) both phases move time forward; for smaller steps
+// the first phase just takes centres, and only the second phase steps
+static Node* advance(Node* node, int stepExponent)
+{
+    auto memoized = node->results.find(stepExponent);
+    if (memoized != node->results.end())
+        return memoized->second;
+
+    Node* result;
+
+    if (node->population == 0) {
+        // Nothing here, and nothing bordering it - nothing will happen
+        result = emptyNode(node->level - 1);
+    }
+    else if (node->level == 2) {
+        result = advance4x4(node);
+    }
+    else {
+        Node** c = node->children;
+        bool fullSpeed = stepExponent == node->level - 2;
+
+        // The nine overlapping level-(n-1) squares: the four children, the
+        // four edge-centred squares between them, and the centre
+        Node* squares[9] = {
+            c[0],
+            join(c[0]->children[1], c[1]->children[0], c[0]->children[3], c[1]->children[2]),
+            c[1],
+            join(c[0]->children[2], c[0]->children[3], c[2]->children[0], c[2]->children[1]),
+            centre(node),
+            join(c[1]->children[2], c[1]->children[3], c[3]->children[0], c[3]->children[1]),
+            c[2],
+            join(c[2]->children[1], c[3]->children[0], c[2]->children[3], c[3]->children[2]),
+            c[3],
+        };
+
+        // Phase one: reduce the nine squares a level, stepping them forward
+        // 2^(level - 3) generations at full speed and not at all otherwise
+        Node* stepped[9];
+        for (int i = 0; i < 9; i++)
+            stepped[i] = fullSpeed ? advance(squares[i], node->level - 3) : centre(squares[i]);
+
+        // Phase two: assemble the four quadrants of the result and step
+        // them the rest of the way
+        int remaining = fullSpeed ? node->level - 3 : stepExponent;
+
+        result = join(advance(join(stepped[0], stepped[1], stepped[3], stepped[4]), remaining),
+                      advance(join(stepped[1], stepped[2], stepped[4], stepped[5]), remaining),
+                      advance(join(stepped[3], stepped[4], stepped[6], stepped[7]), remaining),
+                      advance(join(stepped[4], stepped[5], stepped[7], stepped[8]), remaining));
+    }
+
+    node->results[stepExponent] = result;
+    return result;
+}
+
+// Build the tree for a 2^level square with its top-left corner at
+// (x0, y0), where board cell (x, y) sits at (x + offsetX, y + offsetY)
+static Node* buildNode(const uint32_t* board, int width, int height, int wordsPerRow,
+                       int level, long long x0, long long y0, long long offsetX, long long offsetY)
+{
+    if (level == 0) {
+        long long x = x0 - offsetX;
+        long long y = y0 - offsetY;
+
+        bool alive = x >= 0 && x < width && y >= 0 && y < height
+            && ((board[y * wordsPerRow + x / 32] >> (x % 32)) & 1) != 0;
+
+        return alive ? liveCell : deadCell;
+    }
+
+    long long half = 1LL << (level - 1);
+
+    return join(buildNode(board, width, height, wordsPerRow, level - 1, x0, y0, offsetX, offsetY),
+                buildNode(board, width, height, wordsPerRow, level - 1, x0 + half, y0, offsetX, offsetY),
+                buildNode(board, width, height, wordsPerRow, level - 1, x0, y0 + half, offsetX, offsetY),
+                buildNode(board, width, height, wordsPerRow, level - 1, x0 + half, y0 + half, offsetX, offsetY));
+}
+
+// Write a node's live cells back into the packed board, skipping dead
+// regions wholesale (which is most of the tree). Coordinates as buildNode
+static void fillBoard(Node* node, uint32_t* board, int width, int height, int wordsPerRow,
+                      long long x0, long long y0, long long offsetX, long long offsetY)
+{
+    if (node->population == 0)
+        return;
+
+    if (node->level == 0) {
+        long long x = x0 - offsetX;
+        long long y = y0 - offsetY;
+
+        if (x >= 0 && x < width && y >= 0 && y < height)
+            board[y * wordsPerRow + x / 32] |= 1u << (x % 32);
+
+        return;
+    }
+
+    // Prune subtrees that lie entirely outside the board
+    long long size = 1LL << node->level;
+    if (x0 + size <= offsetX || x0 >= offsetX + width || y0 + size <= offsetY || y0 >= offsetY + height)
+        return;
+
+    long long half = size / 2;
+
+    fillBoard(node->children[0], board, width, height, wordsPerRow, x0, y0, offsetX, offsetY);
+    fillBoard(node->children[1], board, width, height, wordsPerRow, x0 + half, y0, offsetX, offsetY);
+    fillBoard(node->children[2], board, width, height, wordsPerRow, x0, y0 + half, offsetX, offsetY);
+    fillBoard(node->children[3], board, width, height, wordsPerRow, x0 + half, y0 + half, offsetX, offsetY);
+}
+
+void hashlifeAdvance(uint32_t* packedBoard, int width, int height, int wordsPerRow, long long generations)
+{
+    deadCell = makeLeaf(0);
+    liveCell = makeLeaf(1);
+
+    // A square big enough to hold the whole board, with the board centred
+    // in it - centring survives every expand and advance below, so the same
+    // offset arithmetic finds the board again at the end
+    int level = 1;
+    while ((1LL << level) < std::max(width, height))
+        level++;
+
+    long long offsetX = ((1LL << level) - width) / 2;
+    long long offsetY = ((1LL << level) - height) / 2;
+
+    Node* root = buildNode(packedBoard, width, height, wordsPerRow, level, 0, 0, offsetX, offsetY);
+
+    // Peel the generation count off as powers of two, biggest first. Each
+    // advance() call consumes one level, so pad beforehand until the tree
+    // is deep enough for the step and all the live cells sit far enough
+    // inside that nothing can reach the edge of the result
+    for (int k = 62; k >= 0; k--) {
+        if (((generations >> k) & 1) == 0)
+            continue;
+
+        while (root->level < k + 3 || root->population != centre(centre(root))->population)
+            root = expand(root);
+
+        root = advance(root, k);
+    }
+
+    // Clip the plane back down to the board
+    while (root->level < level)
+        root = expand(root);
+
+    offsetX = ((1LL << root->level) - width) / 2;
+    offsetY = ((1LL << root->level) - height) / 2;
+
+    std::fill(packedBoard, packedBoard + (size_t)wordsPerRow * height, 0);
+    fillBoard(root, packedBoard, width, height, wordsPerRow, 0, 0, offsetX, offsetY);
+
+    // Free the whole arena - the engine runs once, up front, and shouldn't
+    // keep hold of memory while the interactive app runs
+    for (Node* node : allNodes)
+        delete node;
+
+    allNodes.clear();
+    nodeTable.clear();
+    emptyNodes.clear();
+    deadCell = NULL;
+    liveCell = NULL;
+}
@@ -0,0 +1,24 @@
+/*
+* hashlife.h
+*
+* An offline fast-forward engine: a HashLife-style quadtree of hash-consed
+* macrocells with memoized step results. Identical regions of the board
+* share one node, and a node that has been advanced once never needs
+* computing again - for the sparse, periodic patterns we mostly run, that
+* turns jumps of millions of generations into seconds of work.
+*
+* One caveat: HashLife naturally simulates an unbounded plane, so a
+* fast-forwarded board only matches the texture path's dead-boundary
+* results while the pattern stays clear of the board edges. Anything that
+* escapes the board is clipped on the way back out.
+*/
+
+#pragma once
+
+#include <cstdint>
+
+// Advance the packed board (32 cells per word, wordsPerRow words per row,
+// same layout as the textures) by the given number of generations, in
+// place. All of the engine's working memory is freed again before this
+// returns
+void hashlifeAdvance(uint32_t* packedBoard, int width, int height, int wordsPerRow, long long generations);
@@ -1,12 +1,81 @@
-#version 430
+#version 330 core
 in vec2 TexCoord;
 out vec4 FragColor;
 
-uniform sampler2D displayTexture;
+uniform usampler2D displayTexture;
+uniform usampler2D ageTexture;
+uniform usampler2D coarseTexture;
+uniform usampler2DArray historyTexture;
 uniform float scale;
 uniform vec2 offset;
+uniform ivec2 gridSize;
+
+// 0 = classic black & white cells, 1 = cell-age heatmap
+uniform int displayMode;
+
+// When set, sample the coarse "anything alive in this 32x32 block" overview
+// instead of digging individual bits out of the full-resolution board -
+// used when we're zoomed out far enough that a pixel covers a whole block
+uniform int useCoarse;
+
+// Rewind and diff views: historyLayer picks a stored generation to show
+// instead of the live board (-1 = live), and diffLayer a second one to
+// compare against (-1 = no diff) - births glow green, deaths red
+uniform int historyLayer;
+uniform int diffLayer;
 
 void main()
 {
-	FragColor = texture(displayTexture, (TexCoord / scale) + offset);
-}
\ No newline at end of file
+	vec2 boardCoord = (TexCoord / scale) + offset;
+
+	// Outside the board itself, draw a white border
+	if (boardCoord.x < 0.0 || boardCoord.x >= 1.0 || boardCoord.y < 0.0 || boardCoord.y >= 1.0) {
+		FragColor = vec4(1.0);
+		return;
+	}
+
+	// Work out which cell sits under this fragment, then dig its bit out of
+	// the packed texture - each 32-bit texel holds 32 cells along the row
+	ivec2 cell = ivec2(boardCoord * vec2(gridSize));
+
+	if (useCoarse == 1) {
+		uint anyAlive = texelFetch(coarseTexture, ivec2(cell.x >> 5, cell.y >> 5), 0).x;
+		FragColor = vec4(vec3(anyAlive), 1.0);
+		return;
+	}
+
+	uint word;
+	if (historyLayer >= 0)
+		word = texelFetch(historyTexture, ivec3(cell.x >> 5, cell.y, historyLayer), 0).x;
+	else
+		word = texelFetch(displayTexture, ivec2(cell.x >> 5, cell.y), 0).x;
+
+	float alive = float((word >> (cell.x & 31)) & 1u);
+
+	if (diffLayer >= 0) {
+		uint oldWord = texelFetch(historyTexture, ivec3(cell.x >> 5, cell.y, diffLayer), 0).x;
+		float wasAlive = float((oldWord >> (cell.x & 31)) & 1u);
+
+		// Births green, deaths red, surviving cells a dim grey
+		if (alive > wasAlive)
+			FragColor = vec4(0.2, 1.0, 0.2, 1.0);
+		else if (wasAlive > alive)
+			FragColor = vec4(1.0, 0.2, 0.2, 1.0);
+		else
+			FragColor = vec4(vec3(alive * 0.4), 1.0);
+
+		return;
+	}
+
+	if (displayMode == 1) {
+		// Heatmap view: newborn cells glow yellow-white and cool down to a
+		// deep red the longer they survive - handy for spotting oscillators
+		float age = float(texelFetch(ageTexture, cell, 0).x) / 255.0;
+		vec3 palette = mix(vec3(1.0, 1.0, 0.4), vec3(0.6, 0.05, 0.05), age);
+
+		FragColor = vec4(alive * palette, 1.0);
+		return;
+	}
+
+	FragColor = vec4(alive, alive, alive, 1.0);
+}
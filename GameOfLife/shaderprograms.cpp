@@ -0,0 +1,233 @@
+/*
+* shaderprograms.cpp
+*
+* Shader compilation and the program binary cache. See shaderprograms.h for
+* the interface.
+*/
+
+#include "shaderprograms.h"
+
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <vector>
+#include <cstdio>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+std::string loadShaderSource(const char* shaderPath)
+{
+    // Load in our shader code
+    std::string shaderSource;
+    std::ifstream shaderFile;
+
+    // Make sure an exception will be thrown if an error occurs
+    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+
+    try
+    {
+        // Open the file, and read in the source to a stream
+        shaderFile.open(shaderPath);
+        std::stringstream shaderSourceStream;
+        shaderSourceStream << shaderFile.rdbuf();
+
+        // Close the file, and convert to a std::string
+        shaderFile.close();
+        shaderSource = shaderSourceStream.str();
+    }
+    catch (std::ifstream::failure e)
+    {
+        std::cerr << "Couldn't load " << shaderPath << std::endl;
+        return "";
+    }
+
+    return shaderSource;
+}
+
+std::string injectShaderPrelude(const std::string& shaderSource, const char* prelude)
+{
+    size_t firstLineEnd = shaderSource.find('\n');
+
+    if (firstLineEnd == std::string::npos)
+        return shaderSource + "\n" + prelude;
+
+    return shaderSource.substr(0, firstLineEnd + 1) + prelude + shaderSource.substr(firstLineEnd + 1);
+}
+
+GLuint compileShader(const char* shaderName, const std::string& shaderSource, GLenum shaderType)
+{
+    // From a std::string to a C string
+    const char* shaderSourceString = shaderSource.c_str();
+
+    // Create & compile a new shader
+    GLuint shader = glCreateShader(shaderType);
+    glShaderSource(shader, 1, &shaderSourceString, NULL);
+    glCompileShader(shader);
+
+    int success;
+    char infoLog[512];
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+
+    if (!success)
+    {
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cerr << "Shader compilation error in " << shaderName << " :\n" << infoLog << std::endl;
+        return -1;
+    }
+
+    return shader;
+}
+
+GLuint createLinkProgram(GLuint shaders[], unsigned int numShaders)
+{
+    GLuint program = glCreateProgram();
+
+    // Attach all of the shaders we've been given to the new program
+    for (unsigned int i = 0; i < numShaders; i++)
+    {
+        glAttachShader(program, shaders[i]);
+    }
+
+    // Ask the driver to keep the linked binary around, so we can stash it in
+    // the on-disk cache afterwards (this has to be set before linking)
+    if (GLAD_GL_VERSION_4_1)
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    // Link all of our shaders together
+    glLinkProgram(program);
+
+    int success;
+    char infoLog[512];
+
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+    if (!success) {
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
+        std::cout << "Shader link error:\n" << infoLog << std::endl;
+    }
+
+    return program;
+}
+
+uint64_t hashString(uint64_t hash, const std::string& text)
+{
+    for (char c : text) {
+        hash ^= (unsigned char)c;
+        hash *= 1099511628211ull;
+    }
+
+    return hash;
+}
+
+// Where a cached program binary for the given key lives on disk
+static std::string programCachePath(uint64_t cacheKey)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "shadercache/%016llx.bin", (unsigned long long)cacheKey);
+    return path;
+}
+
+// Try to revive a previously-linked program from the binary cache. Returns 0
+// if there's no usable entry (missing, or the driver rejects it)
+static GLuint loadCachedProgramBinary(uint64_t cacheKey)
+{
+    std::ifstream cacheFile(programCachePath(cacheKey), std::ios::binary);
+    if (!cacheFile)
+        return 0;
+
+    // The file is just the driver's binary format enum followed by the blob
+    GLenum binaryFormat = 0;
+    cacheFile.read((char*)&binaryFormat, sizeof(binaryFormat));
+
+    std::vector<char> binary((std::istreambuf_iterator<char>(cacheFile)), std::istreambuf_iterator<char>());
+    if (binary.empty())
+        return 0;
+
+    GLuint program = glCreateProgram();
+    glProgramBinary(program, binaryFormat, binary.data(), (GLsizei)binary.size());
+
+    // The driver is free to reject a binary it can no longer use (the key
+    // includes the driver version string, but that doesn't catch everything)
+    int success;
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
+
+    if (!success) {
+        glDeleteProgram(program);
+        return 0;
+    }
+
+    return program;
+}
+
+// Stash a freshly-linked program's binary in the cache for next launch
+static void storeProgramBinary(GLuint program, uint64_t cacheKey)
+{
+    GLint binaryLength = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &binaryLength);
+    if (binaryLength <= 0)
+        return;
+
+    std::vector<char> binary(binaryLength);
+    GLenum binaryFormat = 0;
+    GLsizei bytesWritten = 0;
+    glGetProgramBinary(program, binaryLength, &bytesWritten, &binaryFormat, binary.data());
+    if (bytesWritten <= 0)
+        return;
+
+#ifdef _WIN32
+    _mkdir("shadercache");
+#else
+    mkdir("shadercache", 0755);
+#endif
+
+    std::ofstream cacheFile(programCachePath(cacheKey), std::ios::binary | std::ios::trunc);
+    cacheFile.write((const char*)&binaryFormat, sizeof(binaryFormat));
+    cacheFile.write(binary.data(), bytesWritten);
+}
+
+GLuint loadProgramCached(const char* shaderPaths[], const GLenum shaderTypes[], unsigned int numShaders, const char* prelude)
+{
+    std::vector<std::string> sources(numShaders);
+    uint64_t cacheKey = 14695981039346656037ull;
+
+    for (unsigned int i = 0; i < numShaders; i++) {
+        sources[i] = loadShaderSource(shaderPaths[i]);
+        if (sources[i].empty())
+            return -1;
+
+        if (prelude != NULL)
+            sources[i] = injectShaderPrelude(sources[i], prelude);
+
+        cacheKey = hashString(cacheKey, sources[i]);
+    }
+
+    cacheKey = hashString(cacheKey, (const char*)glGetString(GL_RENDERER));
+    cacheKey = hashString(cacheKey, (const char*)glGetString(GL_VERSION));
+
+    // Program binaries need GL 4.1; without them we just compile every launch
+    bool cacheUsable = GLAD_GL_VERSION_4_1 != 0;
+
+    if (cacheUsable) {
+        GLuint cachedProgram = loadCachedProgramBinary(cacheKey);
+        if (cachedProgram != 0)
+            return cachedProgram;
+    }
+
+    // Cache miss - compile and link the real thing
+    std::vector<GLuint> shaders(numShaders);
+    for (unsigned int i = 0; i < numShaders; i++)
+        shaders[i] = compileShader(shaderPaths[i], sources[i], shaderTypes[i]);
+
+    GLuint program = createLinkProgram(shaders.data(), numShaders);
+
+    for (unsigned int i = 0; i < numShaders; i++)
+        glDeleteShader(shaders[i]);
+
+    if (cacheUsable)
+        storeProgramBinary(program, cacheKey);
+
+    return program;
+}
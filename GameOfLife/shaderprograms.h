@@ -0,0 +1,39 @@
+/*
+* shaderprograms.h
+*
+* Shader loading, compilation and program linking, plus the on-disk program
+* binary cache that makes warm starts skip compilation entirely. Shared by
+* the simulation engine and whatever frontend is driving it - everything
+* here just needs a current GL context.
+*/
+
+#pragma once
+
+#include <glad/gl.h>
+
+#include <string>
+#include <cstdint>
+
+// Read a shader's source off disk ("" on failure, with a complaint printed)
+std::string loadShaderSource(const char* shaderPath);
+
+// Splice extra #define lines in just after the #version directive - GLSL
+// insists #version comes first, so a prelude can't simply be prepended
+std::string injectShaderPrelude(const std::string& shaderSource, const char* prelude);
+
+// Compile one shader, printing the info log on failure
+GLuint compileShader(const char* shaderName, const std::string& shaderSource, GLenum shaderType);
+
+// Link the given compiled shaders into a program
+GLuint createLinkProgram(GLuint shaders[], unsigned int numShaders);
+
+// FNV-1a - not cryptographic, but plenty to key a shader cache
+uint64_t hashString(uint64_t hash, const std::string& text);
+
+// Build a program from the given shader files, going through the on-disk
+// binary cache: a warm start skips compilation and linking entirely. The
+// cache key covers every source file plus the driver's version strings, so
+// an edited shader or updated driver can never be served a stale binary.
+// An optional prelude of #defines is spliced into every source first - the
+// key is hashed after splicing, so each specialization caches separately
+GLuint loadProgramCached(const char* shaderPaths[], const GLenum shaderTypes[], unsigned int numShaders, const char* prelude = NULL);